@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""
+Compile-time cost benchmark
+
+For each (order, variable count) case, a translation unit instantiating
+make_filter on a generated laplace transfert function is compiled, and the
+following are recorded :
+
+    compile_time_s      wall clock compilation time
+    peak_memory_kb      peak resident memory of the compiler
+    symbol_count        symbols in the object file (instantiated functions)
+    object_size         size of the object file in bytes
+    instantiations      template instantiations, with clang --time-trace only
+
+Results are written as JSON. Usage :
+
+    python3 benchmark/compile_time.py --orders 1-12 --variables 1-8 --output compile_time.json
+"""
+
+import argparse
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def parse_range(text):
+    """ '1-12' or '1,2,4' or '3' """
+    values = []
+    for part in text.split(','):
+        if '-' in part:
+            first, last = part.split('-')
+            values.extend(range(int(first), int(last) + 1))
+        else:
+            values.append(int(part))
+    return values
+
+
+def laplace_transfert_function(order, variable_count):
+    """
+    Lowpass made of second order sections (and a first order one when the
+    order is odd). Section coefficients cycle over the variables, variables
+    left over scale the numerator.
+    """
+    names = ['v{}'.format(i) for i in range(variable_count)]
+    next_variable = [0]
+
+    def take():
+        name = names[next_variable[0] % variable_count]
+        next_variable[0] += 1
+        return name
+
+    sections = []
+    for _ in range(order // 2):
+        sections.append('(1 + {} * s + {} * {} * s * s)'.format(take(), take(), take()))
+    if order % 2 == 1:
+        sections.append('(1 + {} * s)'.format(take()))
+
+    numerator = ' * '.join(names[next_variable[0]:]) or '1'
+    return names, '{} / ({})'.format(numerator, ' * '.join(sections))
+
+
+def generate_source(order, variable_count):
+    names, transfert_function = laplace_transfert_function(order, variable_count)
+
+    lines = ['#include "meta_filter.h"', '']
+    for name in names:
+        lines.append('struct {0}_tag;'.format(name))
+        lines.append('constexpr auto {0} = variable<{0}_tag>{{}};'.format(name))
+
+    lines += [
+        '',
+        'float process(float* buffer, std::size_t count)',
+        '{',
+        '    auto filter = make_filter<float>({});'.format(transfert_function),
+        '    filter.set_variable(T, 1.f / 48000.f);',
+    ]
+    for i, name in enumerate(names):
+        lines.append('    filter.set_variable({}, {}f);'.format(name, 0.5 + 0.1 * i))
+    lines += [
+        '    filter.process_block(buffer, count);',
+        '    return filter.process_one_sample(0.f);',
+        '}',
+        '',
+    ]
+    return '\n'.join(lines)
+
+
+def count_symbols(object_path):
+    nm = shutil.which('nm')
+    if nm is None:
+        return None
+    result = subprocess.run([nm, object_path], capture_output=True, text=True)
+    return len(result.stdout.splitlines()) if result.returncode == 0 else None
+
+
+def count_instantiations(trace_path):
+    """ Instantiation events of a clang -ftime-trace file """
+    try:
+        with open(trace_path) as trace:
+            events = json.load(trace)['traceEvents']
+    except (OSError, ValueError, KeyError):
+        return None
+    return sum(1 for event in events if event.get('name') in ('InstantiateClass', 'InstantiateFunction'))
+
+
+def run_case(cxx, flags, order, variable_count, timeout, work_dir, time_trace):
+    source_path = os.path.join(work_dir, 'order{}_vars{}.cpp'.format(order, variable_count))
+    object_path = source_path[:-4] + '.o'
+    log_path = source_path[:-4] + '.log'
+
+    with open(source_path, 'w') as source:
+        source.write(generate_source(order, variable_count))
+
+    command = [cxx] + flags + ['-I', REPO_ROOT, '-c', source_path, '-o', object_path]
+    if time_trace:
+        command.append('-ftime-trace')
+    result = {'order': order, 'variables': variable_count}
+
+    with open(log_path, 'w') as log:
+        start = time.monotonic()
+        process = subprocess.Popen(command, stdout=subprocess.DEVNULL, stderr=log)
+
+        # wait4 reports the peak memory of the compiler driver and of its children
+        while True:
+            pid, status, usage = os.wait4(process.pid, os.WNOHANG)
+            elapsed = time.monotonic() - start
+            if pid != 0:
+                break
+            if elapsed > timeout:
+                process.kill()
+                _, status, usage = os.wait4(process.pid, 0)
+                result.update({'status': 'timeout', 'compile_time_s': timeout, 'peak_memory_kb': usage.ru_maxrss})
+                return result
+            time.sleep(0.01)
+
+    process.returncode = os.waitstatus_to_exitcode(status)
+    result.update({'compile_time_s': round(elapsed, 3), 'peak_memory_kb': usage.ru_maxrss})
+
+    if process.returncode != 0:
+        with open(log_path) as log:
+            result.update({'status': 'error', 'message': log.read()[-2000:]})
+        return result
+
+    result.update({
+        'status': 'ok',
+        'symbol_count': count_symbols(object_path),
+        'object_size': os.path.getsize(object_path),
+    })
+    if time_trace:
+        result['instantiations'] = count_instantiations(object_path[:-2] + '.json')
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--orders', default='1-12', help='filter orders, e.g. 1-12 or 2,4,8')
+    parser.add_argument('--variables', default='1-8', help='variable counts, e.g. 1-8')
+    parser.add_argument('--cxx', default=os.environ.get('CXX', 'g++'))
+    parser.add_argument('--flags', default='-std=c++17 -O2', help='compiler flags')
+    parser.add_argument('--timeout', type=float, default=600.0, help='per case timeout in seconds')
+    parser.add_argument('--output', help='JSON output file (default : stdout)')
+    parser.add_argument('--time-trace', action='store_true', help='count instantiations (clang only)')
+    parser.add_argument('--keep', action='store_true', help='keep the generated sources')
+    arguments = parser.parse_args()
+
+    flags = arguments.flags.split()
+    work_dir = tempfile.mkdtemp(prefix='meta_filter_compile_time_')
+    results = []
+
+    try:
+        for variable_count in parse_range(arguments.variables):
+            for order in parse_range(arguments.orders):
+                result = run_case(arguments.cxx, flags, order, variable_count, arguments.timeout, work_dir, arguments.time_trace)
+                results.append(result)
+                print('order {:2d}  variables {}  {:8s} {:9.2f} s {:9d} kB'.format(
+                    order, variable_count, result['status'],
+                    result.get('compile_time_s', 0.0), result['peak_memory_kb']), file=sys.stderr)
+
+                # Higher orders only cost more : stop at the first timeout
+                if result['status'] == 'timeout':
+                    break
+    finally:
+        if not arguments.keep:
+            shutil.rmtree(work_dir, ignore_errors=True)
+
+    report = {
+        'compiler': arguments.cxx,
+        'flags': arguments.flags,
+        'machine': platform.machine(),
+        'results': results,
+    }
+
+    if arguments.output:
+        with open(arguments.output, 'w') as output:
+            json.dump(report, output, indent=2)
+    else:
+        json.dump(report, sys.stdout, indent=2)
+
+
+if __name__ == '__main__':
+    main()
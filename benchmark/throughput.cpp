@@ -0,0 +1,183 @@
+/*
+ *  Runtime throughput benchmark
+ *
+ *  Measures ns/sample of iir_filter_implementation for Butterworth lowpass
+ *  designs of order 1 to 8, in float and double, for each realization :
+ *
+ *      - per_sample : process_one_sample over the buffer
+ *      - block      : process_block over blocks of block_size samples
+ *
+ *  each with fixed parameters, and with the cutoff changed before every block
+ *  (which forces the coefficients to be re-evaluated). Results are written as JSON.
+ *
+ *      g++ -std=c++17 -O3 -march=native -I. benchmark/throughput.cpp -o throughput
+ *      ./throughput [block_size] > throughput.json
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "meta_filter.h"
+
+struct tau_tag;
+constexpr auto tau = variable<tau_tag>{};
+
+namespace {
+
+constexpr double pi = 3.14159265358979323846;
+constexpr double sample_rate = 48000.0;
+constexpr std::size_t buffer_size = 1u << 14;
+constexpr auto repetitions = 7;
+constexpr double min_duration_s = 0.02;
+
+/*
+ *  Butterworth lowpass of order N : second order sections
+ *  1 + q tau s + (tau s)^2, and 1 + tau s when N is odd
+ */
+template <unsigned int Order, unsigned int Section = 0u>
+auto butterworth_denominator()
+{
+    if constexpr (2u * Section + 1u == Order) {
+        return 1 + tau * s;
+    }
+    else {
+        const double q = 2.0 * std::sin((2.0 * Section + 1.0) * pi / (2.0 * Order));
+        const auto section = 1 + q * tau * s + tau * tau * s * s;
+
+        if constexpr (2u * Section + 2u == Order)
+            return section;
+        else
+            return section * butterworth_denominator<Order, Section + 1u>();
+    }
+}
+
+template <unsigned int Order>
+auto butterworth_lowpass()
+{
+    return 1 / butterworth_denominator<Order>();
+}
+
+double cutoff_tau(double frequency)
+{
+    return 1.0 / (2.0 * pi * frequency);
+}
+
+volatile double sink;
+
+//  Median of the ns/sample of several runs, each one long enough to be timed
+template <typename Run>
+double measure_ns_per_sample(Run run)
+{
+    using clock = std::chrono::steady_clock;
+    std::vector<double> results;
+
+    for (auto repetition = 0; repetition < repetitions; ++repetition) {
+        std::size_t samples = 0u;
+        const auto start = clock::now();
+        double elapsed = 0.0;
+
+        do {
+            samples += run();
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        } while (elapsed < min_duration_s);
+
+        results.push_back(elapsed * 1e9 / static_cast<double>(samples));
+    }
+
+    std::sort(results.begin(), results.end());
+    return results[results.size() / 2u];
+}
+
+template <typename Tsample, typename Realization, unsigned int Order>
+void benchmark_filter(const char* type_name, const char* realization_name, std::size_t block_size, bool& first)
+{
+    auto filter = make_filter<Tsample, Realization>(butterworth_lowpass<Order>());
+    const auto block_count = buffer_size / block_size;
+
+    std::vector<Tsample> input(buffer_size);
+    std::vector<Tsample> output(buffer_size);
+    for (auto i = 0u; i < buffer_size; ++i)
+        input[i] = static_cast<Tsample>(std::rand()) / static_cast<Tsample>(RAND_MAX) - Tsample{0.5};
+
+    for (const auto modulated : {false, true}) {
+        for (const auto block : {false, true}) {
+            filter.reset();
+            filter.set_variable(T, Tsample(1.0 / sample_rate));
+            filter.set_variable(tau, Tsample(cutoff_tau(1000.0)));
+
+            auto block_index = 0u;
+
+            const auto ns_per_sample = measure_ns_per_sample(
+                [&]()
+                {
+                    for (auto b = 0u; b < block_count; ++b) {
+                        const auto offset = b * block_size;
+
+                        if (modulated)
+                            filter.set_variable(tau, Tsample(cutoff_tau(1000.0 + 100.0 * (block_index++ % 2u))));
+
+                        if (block) {
+                            filter.process_block(input.data() + offset, output.data() + offset, block_size);
+                        }
+                        else {
+                            for (auto i = offset; i < offset + block_size; ++i)
+                                output[i] = filter.process_one_sample(input[i]);
+                        }
+                    }
+
+                    sink = output[buffer_size - 1u];
+                    return block_count * block_size;
+                });
+
+            std::cout
+                << (first ? "" : ",\n")
+                << "    {\"order\": " << Order
+                << ", \"type\": \"" << type_name << "\""
+                << ", \"realization\": \"" << realization_name << "\""
+                << ", \"mode\": \"" << (block ? "block" : "per_sample") << "\""
+                << ", \"modulated\": " << (modulated ? "true" : "false")
+                << ", \"ns_per_sample\": " << ns_per_sample
+                << ", \"samples_per_second\": " << 1e9 / ns_per_sample << "}";
+            first = false;
+        }
+    }
+}
+
+template <typename Tsample, typename Realization, unsigned int ...Orders>
+void benchmark_orders(
+    const std::integer_sequence<unsigned int, Orders...>&,
+    const char* type_name, const char* realization_name, std::size_t block_size, bool& first)
+{
+    (..., benchmark_filter<Tsample, Realization, Orders + 1u>(type_name, realization_name, block_size, first));
+}
+
+template <typename Tsample>
+void benchmark_realizations(const char* type_name, std::size_t block_size, bool& first)
+{
+    using orders = std::make_integer_sequence<unsigned int, 8>;
+    benchmark_orders<Tsample, direct_form_1>(orders{}, type_name, "direct_form_1", block_size, first);
+    benchmark_orders<Tsample, transposed_direct_form_2>(orders{}, type_name, "transposed_direct_form_2", block_size, first);
+    benchmark_orders<Tsample, second_order_sections>(orders{}, type_name, "second_order_sections", block_size, first);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t block_size =
+        std::clamp<std::size_t>(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64u, 1u, buffer_size);
+    bool first = true;
+
+    std::cout << "{\n  \"block_size\": " << block_size << ",\n  \"results\": [\n";
+    benchmark_realizations<float>("float", block_size, first);
+    benchmark_realizations<double>("double", block_size, first);
+    std::cout << "\n  ]\n}\n";
+
+    return 0;
+}
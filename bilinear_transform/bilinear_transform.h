@@ -1,9 +1,18 @@
 #ifndef BILINEAR_TRANSFORM_H_
 #define BILINEAR_TRANSFORM_H_
 
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+#include "../expression/bind.h"
 #include "../expression/expression.h"
+#include "../expression/horner.h"
 #include "../expression/substitute.h"
 #include "../expression/print.h"
+#include "../expression/simplify.h"
+#include "../utils/type_list.h"
+#include "../utils/variable_set.h"
 #include "rational_fraction.h"
 
 struct Z_tag;
@@ -42,20 +51,156 @@ struct print_impl<variable<s_tag>>
     }
 };
 
+/*
+ *  The laplace transfert function is first reduced to a rational fraction
+ *  N(s) / D(s) of order M = max(deg N, deg D). Each s^k is replaced by
+ *
+ *      2^k (Z - 1)^k T^(M - k) (Z + 1)^(M - k) / (T^M (Z + 1)^M)
+ *
+ *  and the common denominator T^M (Z + 1)^M cancels : the z transfert
+ *  function keeps the order M, with no common factors in (Z + 1).
+ */
+
+template <unsigned int Power, typename ...E>
+constexpr auto polynomial_power(const polynomial<E...>& p)
+{
+    if constexpr (Power == 0u)
+        return polynomial{constexpr_constant<int, 1>{}};
+    else
+        return p * polynomial_power<Power - 1u>(p);
+}
+
+template <unsigned int Power, typename E>
+constexpr auto expression_power(const expression<E>& e)
+{
+    if constexpr (Power == 0u)
+        return constexpr_constant<int, 1>{};
+    else if constexpr (Power == 1u)
+        return E{e};
+    else
+        return e * expression_power<Power - 1u>(e);
+}
+
+template <typename ...E, typename ...Tags>
+constexpr auto simplify_coefficients(const polynomial<E...>& p, const type_list<Tags...>& variable_order)
+{
+    return std::apply(
+        [&variable_order](const auto& ...e)
+        {
+            return polynomial{simplify(e, variable_order)...};
+        },
+        p.coefficients);
+}
+
+//  Coefficients in Horner form with respect to all the variables of the transfert function
+template <typename P1, typename P2>
+constexpr auto horner_coefficients(const rational_fraction<P1, P2>& r)
+{
+    using variable_order = variable_set_t<rational_fraction<P1, P2>>;
+
+    const auto horner_polynomial =
+        [](const auto& p)
+        {
+            return std::apply(
+                [](const auto& ...e) { return polynomial{horner_form(e, variable_order{})...}; },
+                p.coefficients);
+        };
+
+    return horner_polynomial(r.numerator) / horner_polynomial(r.denominator);
+}
+
+template <unsigned int Order, unsigned int Degree, typename E>
+constexpr auto bilinear_monomial(const expression<E>& coefficient)
+{
+    constexpr auto z_minus_1 = polynomial{constexpr_constant<int, -1>{}, constexpr_constant<int, 1>{}};
+    constexpr auto z_plus_1 = polynomial{constexpr_constant<int, 1>{}, constexpr_constant<int, 1>{}};
+
+    return
+        polynomial{coefficient * constexpr_constant<int, (1 << Degree)>{} * expression_power<Order - Degree>(T)} *
+        (polynomial_power<Degree>(z_minus_1) * polynomial_power<Order - Degree>(z_plus_1));
+}
+
+template <unsigned int Order, typename ...E, unsigned int ...Degrees>
+constexpr auto bilinear_polynomial(
+    const polynomial<E...>& p,
+    const std::integer_sequence<unsigned int, Degrees...>&)
+{
+    return (... + bilinear_monomial<Order, Degrees>(std::get<Degrees>(p.coefficients)));
+}
+
+template <typename E>
+constexpr auto laplace_rational_fraction(const expression<E>& laplace_transfert_function)
+{
+    const auto fraction = extract_rational_fraction(laplace_transfert_function, s);
+
+    if constexpr (is_rational_fraction_v<std::decay_t<decltype(fraction)>>)
+        return fraction;
+    else
+        return fraction / polynomial{constexpr_constant<int, 1>{}};
+}
+
 template <typename E>
 constexpr auto bilinear_transform(const expression<E>& laplace_transfert_function)
 {
-    constexpr auto bilinear_transform_approximation = 
-        (constexpr_constant<int, 2>{} * (Z - constexpr_constant<int, 1>{})) / 
-        (T                            * (Z + constexpr_constant<int, 1>{}));
+    using variable_order = variable_set_t<E>;
+
+    const auto laplace_fraction =
+        laplace_rational_fraction(simplify(laplace_transfert_function, variable_order{}));
+
+    const auto numerator = simplify_coefficients(laplace_fraction.numerator, variable_order{});
+    const auto denominator = simplify_coefficients(laplace_fraction.denominator, variable_order{});
+
+    using numerator_type = std::decay_t<decltype(numerator)>;
+    using denominator_type = std::decay_t<decltype(denominator)>;
+    constexpr auto order = std::max(numerator_type::degree(), denominator_type::degree());
+
+    const auto z_numerator =
+        bilinear_polynomial<order>(numerator, std::make_integer_sequence<unsigned int, numerator_type::degree() + 1u>{});
+    const auto z_denominator =
+        bilinear_polynomial<order>(denominator, std::make_integer_sequence<unsigned int, denominator_type::degree() + 1u>{});
 
-    const auto first_order_approx_z_transform = 
-        substitute(laplace_transfert_function, s, bilinear_transform_approximation);
+    return horner_coefficients(
+        simplify_coefficients(z_numerator, variable_order{}) /
+        simplify_coefficients(z_denominator, variable_order{}));
+}
+
+/*
+ *  Bound variables are substituted in the coefficients of a transfert
+ *  function, which are simplified again so that their values are folded.
+ */
+
+template <typename ...E, typename ...Tags, typename ...Ts>
+constexpr auto bind_variables(const polynomial<E...>& p, const variable_binding<Tags, Ts>& ...bindings)
+{
+    return std::apply(
+        [&bindings...](const auto& ...e)
+        {
+            return polynomial{bind_variables(e, bindings...)...};
+        },
+        p.coefficients);
+}
+
+template <typename P1, typename P2>
+constexpr auto bind_variables(const rational_fraction<P1, P2>& r)
+{
+    return r;
+}
+
+template <typename P1, typename P2, typename Tag, typename T, typename ...Tags, typename ...Ts>
+constexpr auto bind_variables(
+    const rational_fraction<P1, P2>& r,
+    const variable_binding<Tag, T>& binding,
+    const variable_binding<Tags, Ts>& ...bindings)
+{
+    const auto numerator = bind_variables(r.numerator, binding, bindings...);
+    const auto denominator = bind_variables(r.denominator, binding, bindings...);
 
-    const auto z_transform = 
-        extract_rational_fraction(first_order_approx_z_transform, Z); 
+    using variable_order =
+        variable_set_t<rational_fraction<std::decay_t<decltype(numerator)>, std::decay_t<decltype(denominator)>>>;
 
-    return z_transform;
+    return horner_coefficients(
+        simplify_coefficients(numerator, variable_order{}) /
+        simplify_coefficients(denominator, variable_order{}));
 }
 
 #endif /* BILINEAR_TRANSFORM_H_ */
\ No newline at end of file
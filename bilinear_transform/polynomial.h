@@ -95,7 +95,10 @@ struct add_polynomial_impl<polynomial<E1...>, polynomial<E2...>>
         }
         else {
             static_assert (I < size2);
-            return std::get<I>(p2.coefficients);
+            if constexpr (sub)
+                return constexpr_constant<int, -1>{} * std::get<I>(p2.coefficients);
+            else
+                return std::get<I>(p2.coefficients);
         }
     }
 };
@@ -19,6 +19,12 @@ struct rational_fraction<polynomial<E1...>, polynomial<E2...>> {
 template <typename P1, typename P2>
 rational_fraction(const P1&, const P2&) -> rational_fraction<P1, P2>;
 
+template <typename R>
+constexpr auto is_rational_fraction_v = false;
+
+template <typename P1, typename P2>
+constexpr auto is_rational_fraction_v<rational_fraction<P1, P2>> = true;
+
 template <typename P1, typename P2>
 decltype(auto) operator<<(std::ostream& stream, const rational_fraction<P1, P2>& r)
 {
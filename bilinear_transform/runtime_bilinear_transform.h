@@ -0,0 +1,214 @@
+#ifndef RUNTIME_BILINEAR_TRANSFORM_H_
+#define RUNTIME_BILINEAR_TRANSFORM_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../expression/runtime_expression.h"
+
+/*
+ *  The bilinear transform of bilinear_transform.h, on runtime expressions.
+ *  Polynomials are the node ids of their coefficients, degree k at index k.
+ */
+
+using runtime_polynomial = std::vector<expression_graph::node_id>;
+
+struct runtime_rational_fraction
+{
+    runtime_polynomial numerator;
+    runtime_polynomial denominator;
+};
+
+//  Remove the null leading coefficients (a polynomial keeps at least one coefficient)
+inline runtime_polynomial polynomial_trim(const expression_graph& graph, runtime_polynomial p)
+{
+    while (p.size() > 1u && graph.is_constant(p.back(), 0.0))
+        p.pop_back();
+    return p;
+}
+
+inline runtime_polynomial polynomial_add(
+    expression_graph& graph, const runtime_polynomial& p1, const runtime_polynomial& p2, bool subtract = false)
+{
+    runtime_polynomial result(std::max(p1.size(), p2.size()));
+
+    for (std::size_t k = 0u; k < result.size(); ++k) {
+        const auto c1 = (k < p1.size()) ? p1[k] : graph.constant(0.0);
+        const auto c2 = (k < p2.size()) ? p2[k] : graph.constant(0.0);
+        result[k] = subtract ? graph.sub(c1, c2) : graph.sum(c1, c2);
+    }
+
+    return polynomial_trim(graph, result);
+}
+
+inline runtime_polynomial polynomial_product(
+    expression_graph& graph, const runtime_polynomial& p1, const runtime_polynomial& p2)
+{
+    runtime_polynomial result(p1.size() + p2.size() - 1u, graph.constant(0.0));
+
+    for (std::size_t i = 0u; i < p1.size(); ++i)
+        for (std::size_t j = 0u; j < p2.size(); ++j)
+            result[i + j] = graph.sum(result[i + j], graph.product(p1[i], p2[j]));
+
+    return polynomial_trim(graph, result);
+}
+
+/*
+ *  Rational fraction extraction, with the operators of rational_fraction.h
+ */
+class runtime_fraction_extractor
+{
+
+public:
+    using node_id = expression_graph::node_id;
+
+    runtime_fraction_extractor(expression_graph& graph, node_id variable_index)
+    :   _graph{graph}, _variable_index{variable_index}
+    {}
+
+    //  Operands before the operations using them, with an explicit stack as evaluation_tape
+    runtime_rational_fraction extract(node_id root)
+    {
+        //  Node, and whether its operands were extracted
+        std::vector<std::pair<node_id, bool>> stack{{root, false}};
+
+        while (!stack.empty()) {
+            const auto [id, operands_extracted] = stack.back();
+            stack.pop_back();
+            if (_fractions.count(id) != 0u)
+                continue;
+
+            const auto n = _graph[id];
+            if (operands_extracted || is_leaf(n)) {
+                _fractions.emplace(id, extract_node(id));
+            }
+            else {
+                stack.emplace_back(id, true);
+                stack.emplace_back(n.operand2, false);
+                stack.emplace_back(n.operand1, false);
+            }
+        }
+
+        return _fractions.at(root);
+    }
+
+private:
+    static bool is_leaf(const expression_graph::node& n) noexcept
+    {
+        return
+            n.kind == expression_graph::node_kind::variable ||
+            n.kind == expression_graph::node_kind::constant;
+    }
+
+    //  The operands of an operation are extracted already
+    runtime_rational_fraction extract_node(node_id id)
+    {
+        using node_kind = expression_graph::node_kind;
+        const auto n = _graph[id];
+
+        if (n.kind == node_kind::variable && n.operand1 == _variable_index)
+            return {{_graph.constant(0.0), _graph.constant(1.0)}, {_graph.constant(1.0)}};
+        else if (is_leaf(n))
+            return {{id}, {_graph.constant(1.0)}};
+
+        const auto r1 = _fractions.at(n.operand1);
+        const auto r2 = _fractions.at(n.operand2);
+
+        switch (n.kind) {
+        case node_kind::sum:
+        case node_kind::sub:
+            return {
+                polynomial_add(_graph,
+                    polynomial_product(_graph, r1.numerator, r2.denominator),
+                    polynomial_product(_graph, r2.numerator, r1.denominator),
+                    n.kind == node_kind::sub),
+                polynomial_product(_graph, r1.denominator, r2.denominator)};
+
+        case node_kind::product:
+            return {
+                polynomial_product(_graph, r1.numerator, r2.numerator),
+                polynomial_product(_graph, r1.denominator, r2.denominator)};
+
+        default:
+            return {
+                polynomial_product(_graph, r1.numerator, r2.denominator),
+                polynomial_product(_graph, r1.denominator, r2.numerator)};
+        }
+    }
+
+    expression_graph& _graph;
+    const node_id _variable_index;
+    std::unordered_map<node_id, runtime_rational_fraction> _fractions{};
+};
+
+inline runtime_rational_fraction extract_rational_fraction(
+    expression_graph& graph, expression_graph::node_id e, expression_graph::node_id variable_index)
+{
+    return runtime_fraction_extractor{graph, variable_index}.extract(e);
+}
+
+/*
+ *  Each s^k of a polynomial of order M becomes 2^k (Z - 1)^k T^(M - k) (Z + 1)^(M - k)
+ */
+inline runtime_polynomial bilinear_polynomial(
+    expression_graph& graph, const runtime_polynomial& p, std::size_t order, expression_graph::node_id t)
+{
+    //  Integer coefficients of 2^k (Z - 1)^k (Z + 1)^(M - k)
+    const auto binomial_product =
+        [order](std::size_t k)
+        {
+            std::vector<double> result{static_cast<double>(1u << k)};
+
+            for (std::size_t i = 0u; i < order; ++i) {
+                const double root = (i < k) ? -1.0 : 1.0;
+                result.push_back(0.0);
+                for (auto j = result.size() - 1u; j > 0u; --j)
+                    result[j] = result[j - 1u] + root * result[j];
+                result[0] *= root;
+            }
+
+            return result;
+        };
+
+    std::vector<expression_graph::node_id> t_powers{graph.constant(1.0)};
+    for (std::size_t i = 1u; i <= order; ++i)
+        t_powers.push_back(graph.product(t_powers.back(), t));
+
+    runtime_polynomial result(order + 1u, graph.constant(0.0));
+    for (std::size_t k = 0u; k < p.size(); ++k) {
+        const auto coefficient = graph.product(p[k], t_powers[order - k]);
+        const auto binomial = binomial_product(k);
+
+        for (std::size_t j = 0u; j <= order; ++j)
+            result[j] = graph.sum(result[j], graph.product(graph.constant(binomial[j]), coefficient));
+    }
+
+    return polynomial_trim(graph, result);
+}
+
+/**
+ *  z transfert function of a laplace transfert function. The laplace
+ *  variable is named s and the sampling period T, as for expression
+ *  templates.
+ */
+inline runtime_rational_fraction bilinear_transform(expression_graph& graph, expression_graph::node_id laplace_transfert_function)
+{
+    const auto s_index =
+        graph.has_variable("s") ?
+            graph.variable_index("s") :
+            std::numeric_limits<expression_graph::node_id>::max();
+    const auto t = graph.variable("T");
+
+    const auto laplace_fraction = extract_rational_fraction(graph, laplace_transfert_function, s_index);
+    const auto order = std::max(laplace_fraction.numerator.size(), laplace_fraction.denominator.size()) - 1u;
+
+    return {
+        bilinear_polynomial(graph, laplace_fraction.numerator, order, t),
+        bilinear_polynomial(graph, laplace_fraction.denominator, order, t)};
+}
+
+#endif /* RUNTIME_BILINEAR_TRANSFORM_H_ */
@@ -0,0 +1,239 @@
+/*
+ *  Regression checks
+ *
+ *  Designs whose normalized z coefficients are known exactly (computed by
+ *  hand, or with an independent rational arithmetic bilinear transform),
+ *  checked against the coefficients evaluated by the library, and checks
+ *  of fixed bugs. Prints the failed checks, and exits with a non zero
+ *  status if any.
+ *
+ *      g++ -std=c++17 -O2 -pthread -I. check/regression.cpp -o regression
+ *      ./regression
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <cfenv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "meta_filter.h"
+
+struct tau_tag;
+struct q_tag;
+constexpr auto tau = variable<tau_tag>{};
+constexpr auto q = variable<q_tag>{};
+
+namespace {
+
+int failure_count = 0;
+
+void check(bool condition, const char* name, const char* what)
+{
+    if (!condition) {
+        std::cout << "FAILED " << name << " : " << what << '\n';
+        ++failure_count;
+    }
+}
+
+bool close(double value, double expected, double tolerance = 1e-12)
+{
+    return std::fabs(value - expected) <= tolerance * std::max(1.0, std::fabs(expected));
+}
+
+template <typename Tcoefficients>
+void check_coefficients(
+    const char* name, const Tcoefficients& coefficients,
+    std::initializer_list<double> feedforward, std::initializer_list<double> feedback)
+{
+    std::size_t k = 0u;
+    for (const auto expected : feedforward)
+        check(close(coefficients.feedforward[k++], expected), name, "feedforward");
+
+    k = 0u;
+    for (const auto expected : feedback)
+        check(close(coefficients.feedback[k++], expected), name, "feedback");
+}
+
+//  Subtractions where the right operand is the polynomial of higher degree
+void check_subtractions()
+{
+    auto mix = make_filter<double>((1 - 3 * tau * tau * s * s) / ((1 + tau * s) * (1 + tau * s)));
+    mix.set_variable(T, 1.0);
+    mix.set_variable(tau, 2.0);
+    check_coefficients("mix", mix.coefficients(),
+        {-47.0 / 25.0, 98.0 / 25.0, -47.0 / 25.0}, {-6.0 / 5.0, 9.0 / 25.0});
+
+    //  Lowpass minus bandpass
+    auto difference = make_filter<double>((1 - tau / q * s) / (1 + tau / q * s + tau * tau * s * s));
+    difference.set_variable(T, 1.0);
+    difference.set_variable(tau, 2.0);
+    difference.set_variable(q, 0.7);
+    check_coefficients("lowpass - bandpass", difference.coefficients(),
+        {-11.0 / 53.0, 14.0 / 159.0, 47.0 / 159.0}, {-70.0 / 53.0, 79.0 / 159.0});
+}
+
+//  Divisions by an integer are not folded into integer coefficients (1 / 2 = 0)
+void check_horner_divisions()
+{
+    variable_store<double, tau_tag> store{};
+    store.set<tau_tag>(4.0);
+
+    check(close(store.eval(horner_form(tau / 2, type_list<tau_tag>{})), 2.0), "tau / 2", "value");
+    check(close(store.eval(horner_form(tau * tau / 2 + tau, type_list<tau_tag>{})), 12.0), "tau^2 / 2 + tau", "value");
+    check(close(store.eval(horner_form(tau / 2.0, type_list<tau_tag>{})), 2.0), "tau / 2.0", "value");
+}
+
+//  int32_t samples whose sum of products exceeds 64 bits : outputs saturate, and do not wrap
+void check_fixed_point_headroom()
+{
+    const auto shelf = (1 + tau * s) / (1 + 1.01 * tau * s);
+    auto filter = make_filter<std::int32_t, fixed_point<24>>(35 * shelf * shelf * shelf, bind(T, 1.0), bind(tau, 100.0));
+
+    constexpr auto max = std::numeric_limits<std::int32_t>::max();
+    constexpr auto min = std::numeric_limits<std::int32_t>::min();
+    std::int32_t samples[16];
+    for (auto i = 0u; i < 16u; ++i)
+        samples[i] = (i % 2u == 0u) ? max : min;
+
+    filter.process_block(samples, 16u);
+    for (auto i = 0u; i < 16u; ++i)
+        check(samples[i] == ((i % 2u == 0u) ? max : min), "int32_t fixed point", "saturated output");
+}
+
+//  Coefficients set on the realization are saved, and record counts from the file do not overflow
+void check_snapshots()
+{
+    const char* path = "regression.snapshot";
+    const auto lowpass = make_filter<double>(1 / (1 + tau * s), bind(T, 1.0));
+
+    filter_bank<std::decay_t<decltype(lowpass)>> saved{lowpass, 2u, 1u};
+    saved[0].set_variable(tau, 2.0);
+    auto coefficients = saved[0].coefficients();
+    coefficients.feedforward[0] = 0.25;
+    saved[0].set_coefficients(coefficients);
+    save_snapshot(path, saved);
+
+    filter_bank<std::decay_t<decltype(lowpass)>> loaded{lowpass, 2u, 1u};
+    load_snapshot(path, loaded);
+    check(loaded[0].realization().coefficients().feedforward[0] == 0.25, "snapshot", "realization coefficients");
+
+    //  record_size * record_count wraps to 0, the size of the records of this file
+    snapshot_header header{};
+    std::memcpy(header.magic, snapshot_header::file_magic, sizeof(header.magic));
+    header.version = snapshot_header::current_version;
+    header.byte_order = snapshot_header::native_byte_order;
+    header.record_size = 1u << 31;
+    header.record_count = std::uint64_t{1u} << 33;
+    std::ofstream{path, std::ios::binary}.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    bool rejected = false;
+    try {
+        snapshot_file file{path};
+    }
+    catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    check(rejected, "snapshot", "overflowing record count");
+    std::remove(path);
+}
+
+//  Bound variables are folded the same way into multichannel filters
+void check_multichannel_bindings()
+{
+    const auto lowpass = 1 / (1 + tau / q * s + tau * tau * s * s);
+    auto filter = make_filter<double>(lowpass, bind(T, 1.0), bind(tau, 2.0), bind(q, 0.7));
+    auto multichannel = make_multichannel_filter<double, 4>(lowpass, bind(T, 1.0), bind(tau, 2.0), bind(q, 0.7));
+
+    double samples[4][8] = {{1.0}, {1.0}, {1.0}, {1.0}};
+    double* channels[4] = {samples[0], samples[1], samples[2], samples[3]};
+    multichannel.process_block(channels, 8u);
+
+    for (auto i = 0u; i < 8u; ++i) {
+        const auto expected = filter.process_one_sample((i == 0u) ? 1.0 : 0.0);
+        for (auto channel = 0u; channel < 4u; ++channel)
+            check(close(samples[channel][i], expected), "multichannel bindings", "impulse response");
+    }
+}
+
+//  The lanes of the last group beyond the voices do not divide by zero
+void check_voice_padding()
+{
+    auto voices = make_voice_bank<double, 4>(1 / (1 + tau * s), 3u);
+    const double periods[3] = {1.0, 1.0, 1.0};
+    const double taus[3] = {1.0, 2.0, 3.0};
+    voices.set_variable(T, periods);
+    voices.set_variable(tau, taus);
+
+    double samples[3][8] = {{1.0}, {1.0}, {1.0}};
+    double* buffers[3] = {samples[0], samples[1], samples[2]};
+
+    std::feclearexcept(FE_ALL_EXCEPT);
+    voices.process_block(buffers, 8u);
+    check(!std::fetestexcept(FE_DIVBYZERO | FE_INVALID), "voice padding lanes", "floating point exceptions");
+    check(close(samples[2][0], 1.0 / 7.0), "voice padding lanes", "last voice output");
+}
+
+//  Deeply nested formulas are parse errors, and not stack overflows
+bool parses(const std::string& formula)
+{
+    expression_graph graph{};
+    try {
+        parse_expression(graph, formula);
+        return true;
+    }
+    catch (const std::invalid_argument&) {
+        return false;
+    }
+}
+
+void check_parser_depth()
+{
+    const std::size_t depth = expression_parser::max_depth - 1u;
+    check(parses(std::string(depth, '(') + "tau" + std::string(depth, ')')), "nested parentheses", "parsed");
+    check(parses(std::string(depth, '-') + "tau"), "nested minus", "parsed");
+
+    check(!parses(std::string(300000u, '(') + "tau" + std::string(300000u, ')')), "deep parentheses", "rejected");
+    check(!parses(std::string(300000u, '-') + "tau"), "deep minus", "rejected");
+
+    //  Powers are expanded into product chains
+    check(parses("tau^" + std::to_string(expression_parser::max_exponent)), "power", "parsed");
+    check(!parses("1/(1+tau^200000*s)"), "large power", "rejected");
+
+    //  A flat sum is a chain of operations as deep as it is long, compiled without recursion
+    std::string flat_sum = "1/(1+tau*s";
+    for (auto i = 0u; i < 200000u; ++i)
+        flat_sum += "+a" + std::to_string(i);
+    flat_sum += ")";
+
+    runtime_filter_design<double, 2> design{flat_sum};
+    design.set_variable(design.variable_index("T"), 1.0);
+    design.set_variable(design.variable_index("tau"), 2.0);
+    check(design.order() == 1u, "flat sum", "order");
+    check_coefficients("flat sum", design.coefficients(), {1.0 / 5.0, 1.0 / 5.0}, {-3.0 / 5.0});
+}
+
+}
+
+int main()
+{
+    check_subtractions();
+    check_horner_divisions();
+    check_fixed_point_headroom();
+    check_snapshots();
+    check_multichannel_bindings();
+    check_voice_padding();
+    check_parser_depth();
+
+    if (failure_count != 0)
+        std::cout << failure_count << " failed checks\n";
+    return (failure_count == 0) ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+#ifndef BIND_H_
+#define BIND_H_
+
+#include <type_traits>
+
+#include "expression.h"
+#include "substitute.h"
+
+/**
+ *  Variable binding : a variable whose value is known when the filter
+ *  is built. Bound variables are replaced by their value and folded
+ *  with the other numeric terms, so they cost nothing at runtime.
+ */
+template <typename Tag, typename T>
+struct variable_binding
+{
+    static_assert(std::is_arithmetic_v<T>);
+    T value;
+};
+
+template <typename Tag, typename T>
+constexpr auto bind(const variable<Tag>&, T value)
+{
+    return variable_binding<Tag, T>{value};
+}
+
+template <typename Tag, typename T>
+constexpr auto bind(T value)
+{
+    return variable_binding<Tag, T>{value};
+}
+
+template <typename E>
+constexpr auto bind_variables(const expression<E>& e)
+{
+    return E{e};
+}
+
+template <typename E, typename Tag, typename T, typename ...Tags, typename ...Ts>
+constexpr auto bind_variables(
+    const expression<E>& e,
+    const variable_binding<Tag, T>& binding,
+    const variable_binding<Tags, Ts>& ...bindings)
+{
+    return bind_variables(substitute(e, variable<Tag>{}, binding.value), bindings...);
+}
+
+#endif /* BIND_H_ */
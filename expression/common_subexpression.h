@@ -0,0 +1,267 @@
+#ifndef COMMON_SUBEXPRESSION_H_
+#define COMMON_SUBEXPRESSION_H_
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "expression.h"
+#include "evaluate.h"
+#include "../utils/type_list.h"
+
+/*
+ *  Common subexpression elimination
+ *
+ *  A subexpression made only of variables and constexpr constants is fully
+ *  described by its type : two such subexpressions with the same type always
+ *  have the same value. They are collected without duplicates across a set of
+ *  expressions, operands before the operations using them, so that each one
+ *  is evaluated once. Subtrees holding runtime constants are evaluated in place.
+ */
+
+template <typename E>
+struct is_shareable : std::false_type {};
+
+template <typename E>
+constexpr auto is_shareable_v = is_shareable<E>::value;
+
+template <typename Tag>
+struct is_shareable<variable<Tag>> : std::true_type {};
+
+template <typename T, T Value>
+struct is_shareable<constexpr_constant<T, Value>> : std::true_type {};
+
+template <typename Operator, typename E1, typename E2>
+struct is_shareable<operation<Operator, E1, E2>>
+:   std::bool_constant<is_shareable_v<E1> && is_shareable_v<E2>>
+{};
+
+/*
+ *  shared_subexpressions_t<E...> : type_list of the distinct shareable operations
+ */
+
+template <typename Tlist, typename E, bool Known = type_list_contains_v<Tlist, E>>
+struct shared_subexpressions_insert
+{
+    //  Leaves, and operations already collected with their operands
+    using type = Tlist;
+};
+
+template <typename Tlist, typename E>
+using shared_subexpressions_insert_t = typename shared_subexpressions_insert<Tlist, E>::type;
+
+template <typename Tlist, typename Operator, typename E1, typename E2>
+struct shared_subexpressions_insert<Tlist, operation<Operator, E1, E2>, false>
+{
+    using operands_list =
+        shared_subexpressions_insert_t<
+            shared_subexpressions_insert_t<Tlist, E1>, E2>;
+
+    using type =
+        std::conditional_t<
+            is_shareable_v<operation<Operator, E1, E2>>,
+            type_list_push_back_t<operands_list, operation<Operator, E1, E2>>,
+            operands_list
+        >;
+};
+
+template <typename Tlist, typename ...E>
+struct shared_subexpressions_impl;
+
+template <typename Tlist>
+struct shared_subexpressions_impl<Tlist>
+{
+    using type = Tlist;
+};
+
+template <typename Tlist, typename Efirst, typename ...Elast>
+struct shared_subexpressions_impl<Tlist, Efirst, Elast...>
+{
+    using type =
+        typename shared_subexpressions_impl<
+            shared_subexpressions_insert_t<Tlist, Efirst>, Elast...>::type;
+};
+
+template <typename ...E>
+using shared_subexpressions_t = typename shared_subexpressions_impl<type_list<>, E...>::type;
+
+/*
+ *  subexpression_value_t<E, T> : type of the value of E when variables are T
+ */
+
+template <typename E, typename T>
+struct subexpression_value;
+
+template <typename E, typename T>
+using subexpression_value_t = typename subexpression_value<E, T>::type;
+
+template <typename Tag, typename T>
+struct subexpression_value<variable<Tag>, T>
+{
+    using type = T;
+};
+
+template <typename U, typename T>
+struct subexpression_value<constant<U>, T>
+{
+    using type = U;
+};
+
+template <typename U, U Value, typename T>
+struct subexpression_value<constexpr_constant<U, Value>, T>
+{
+    using type = U;
+};
+
+template <typename Operator, typename E1, typename E2, typename T>
+struct subexpression_value<operation<Operator, E1, E2>, T>
+{
+    using type =
+        decltype(apply_operation<Operator>(
+            std::declval<subexpression_value_t<E1, T>>(),
+            std::declval<subexpression_value_t<E2, T>>()));
+};
+
+/**
+ *  Values of the shared subexpressions. update() evaluates each of them once
+ *  from a variable store, then eval() evaluates expressions reusing them.
+ */
+template <typename T, typename Tshared>
+class subexpression_cache;
+
+template <typename T, typename ...Shared>
+class subexpression_cache<T, type_list<Shared...>>
+{
+
+public:
+    using shared_list = type_list<Shared...>;
+
+    constexpr subexpression_cache() = default;
+
+    template <typename Tstore>
+    constexpr void update(const Tstore& store)
+    {
+        update_impl(std::index_sequence_for<Shared...>{}, store);
+    }
+
+    template <typename Tstore, typename E>
+    constexpr auto eval(const Tstore& store, const expression<E>& e) const
+    {
+        return eval_impl<E>::eval(*this, store, e);
+    }
+
+private:
+    template <typename Tstore, std::size_t ...Indexes>
+    constexpr void update_impl(const std::index_sequence<Indexes...>&, const Tstore& store)
+    {
+        //  Operands are listed before the operations using them
+        (..., (std::get<Indexes>(_values) = eval_shared<Shared>(store)));
+    }
+
+    template <typename E, typename Tstore>
+    constexpr auto eval_shared(const Tstore& store) const
+    {
+        return shared_impl<E>::eval(*this, store);
+    }
+
+    //  Shared subexpressions are evaluated from their type only
+
+    template <typename E, typename Dummy = void>
+    struct shared_impl;
+
+    template <typename Tag, typename Dummy>
+    struct shared_impl<variable<Tag>, Dummy>
+    {
+        template <typename Tstore>
+        static constexpr auto eval(const subexpression_cache&, const Tstore& store)
+        {
+            return store.template get<Tag>();
+        }
+    };
+
+    template <typename U, U Value, typename Dummy>
+    struct shared_impl<constexpr_constant<U, Value>, Dummy>
+    {
+        template <typename Tstore>
+        static constexpr auto eval(const subexpression_cache&, const Tstore&)
+        {
+            return Value;
+        }
+    };
+
+    template <typename Operator, typename E1, typename E2, typename Dummy>
+    struct shared_impl<operation<Operator, E1, E2>, Dummy>
+    {
+        template <typename Tstore>
+        static constexpr auto eval(const subexpression_cache& cache, const Tstore& store)
+        {
+            return apply_operation<Operator>(
+                cache.template shared_value<E1>(store),
+                cache.template shared_value<E2>(store));
+        }
+    };
+
+    template <typename E, typename Tstore>
+    constexpr auto shared_value(const Tstore& store) const
+    {
+        if constexpr (type_list_contains_v<shared_list, E>)
+            return std::get<type_list_index_of_v<shared_list, E>>(_values);
+        else
+            return eval_shared<E>(store);
+    }
+
+    //  Other subexpressions are walked, shared ones are replaced by their value
+
+    template <typename E, typename Dummy = void>
+    struct eval_impl;
+
+    template <typename Tag, typename Dummy>
+    struct eval_impl<variable<Tag>, Dummy>
+    {
+        template <typename Tstore>
+        static constexpr auto eval(const subexpression_cache&, const Tstore& store, const variable<Tag>&)
+        {
+            return store.template get<Tag>();
+        }
+    };
+
+    template <typename U, typename Dummy>
+    struct eval_impl<constant<U>, Dummy>
+    {
+        template <typename Tstore>
+        static constexpr auto eval(const subexpression_cache&, const Tstore&, const constant<U>& cst)
+        {
+            return cst.value;
+        }
+    };
+
+    template <typename U, U Value, typename Dummy>
+    struct eval_impl<constexpr_constant<U, Value>, Dummy>
+    {
+        template <typename Tstore>
+        static constexpr auto eval(const subexpression_cache&, const Tstore&, const constexpr_constant<U, Value>&)
+        {
+            return Value;
+        }
+    };
+
+    template <typename Operator, typename E1, typename E2, typename Dummy>
+    struct eval_impl<operation<Operator, E1, E2>, Dummy>
+    {
+        template <typename Tstore>
+        static constexpr auto eval(const subexpression_cache& cache, const Tstore& store, const operation<Operator, E1, E2>& e)
+        {
+            if constexpr (type_list_contains_v<shared_list, operation<Operator, E1, E2>>)
+                return cache.template shared_value<operation<Operator, E1, E2>>(store);
+            else
+                return apply_operation<Operator>(
+                    cache.eval(store, e.operand1),
+                    cache.eval(store, e.operand2));
+        }
+    };
+
+    std::tuple<subexpression_value_t<Shared, T>...> _values{};
+};
+
+#endif /* COMMON_SUBEXPRESSION_H_ */
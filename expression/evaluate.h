@@ -11,7 +11,7 @@ template <typename T>
 struct evaluate_impl;
 
 template <typename E>
-auto evaluate(const expression<E>& e)
+constexpr auto evaluate(const expression<E>& e)
 {
     return evaluate_impl<E>::eval(e);
 }
@@ -33,18 +33,27 @@ struct evaluate_impl<constexpr_constant<T, Value>> {
     }
 };
 
+/**
+ *  Apply an operator to evaluated operands
+ */
+template <typename Operator, typename T1, typename T2>
+constexpr auto apply_operation(const T1& v1, const T2& v2)
+{
+    if constexpr (std::is_same_v<Operator, sum_operation>)
+        return v1 + v2;
+    else if constexpr (std::is_same_v<Operator, sub_operation>)
+        return v1 - v2;
+    else if constexpr (std::is_same_v<Operator, product_operation>)
+        return v1 * v2;
+    else if constexpr (std::is_same_v<Operator, frac_operation>)
+        return v1 / v2;
+}
+
 template <typename Operator, typename E1, typename E2>
 struct evaluate_impl<operation<Operator, E1, E2>> {
     static constexpr auto eval(const operation<Operator, E1, E2>& e)
     {
-        if constexpr (std::is_same_v<Operator, sum_operation>)
-            return evaluate(e.operand1) + evaluate(e.operand2);
-        else if constexpr (std::is_same_v<Operator, sub_operation>)
-            return evaluate(e.operand1) - evaluate(e.operand2);
-        else if constexpr (std::is_same_v<Operator, product_operation>)
-            return evaluate(e.operand1) * evaluate(e.operand2);
-        else if constexpr (std::is_same_v<Operator, frac_operation>)
-            return evaluate(e.operand1) / evaluate(e.operand2);
+        return apply_operation<Operator>(evaluate(e.operand1), evaluate(e.operand2));
     }
 };
 
@@ -0,0 +1,289 @@
+#ifndef EVALUATION_TAPE_H_
+#define EVALUATION_TAPE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "runtime_expression.h"
+
+/**
+ *  A set of runtime expressions compiled into a flat list of instructions
+ *  on a register file, evaluated without allocation :
+ *
+ *      registers : [variables | constants | temporaries]
+ *
+ *  Operations are scheduled by depth (the longest chain of operations
+ *  below them), then by operator : the tape is a list of runs of
+ *  independent instructions with the same operator, each run being a loop
+ *  with no dispatch per instruction. A temporary register is reused once
+ *  the last instruction reading it ran, so that the register file stays
+ *  small. Outputs are kept in their registers until the next evaluation.
+ */
+template <typename T>
+class evaluation_tape
+{
+
+public:
+    using node_id = expression_graph::node_id;
+
+    evaluation_tape() = default;
+
+    evaluation_tape(const expression_graph& graph, const std::vector<node_id>& outputs)
+    {
+        compiler{graph, *this}.compile(outputs);
+    }
+
+    //  Variables are indexed as in the graph
+    void set_variable(std::size_t index, const T& value) noexcept
+    {
+        _registers[index] = value;
+    }
+
+    const T& get_variable(std::size_t index) const noexcept
+    {
+        return _registers[index];
+    }
+
+    void evaluate() noexcept
+    {
+        T* registers = _registers.data();
+        const instruction* instructions = _instructions.data();
+
+        for (const auto& r : _runs) {
+            switch (r.code) {
+            case opcode::sum:       run(registers, instructions, r, [](const T& a, const T& b) { return a + b; });    break;
+            case opcode::sub:       run(registers, instructions, r, [](const T& a, const T& b) { return a - b; });    break;
+            case opcode::product:   run(registers, instructions, r, [](const T& a, const T& b) { return a * b; });    break;
+            case opcode::frac:      run(registers, instructions, r, [](const T& a, const T& b) { return a / b; });    break;
+            }
+        }
+    }
+
+    const T& output(std::size_t index) const noexcept
+    {
+        return _registers[_outputs[index]];
+    }
+
+    std::size_t output_count() const noexcept
+    {
+        return _outputs.size();
+    }
+
+    std::size_t instruction_count() const noexcept
+    {
+        return _instructions.size();
+    }
+
+    std::size_t run_count() const noexcept
+    {
+        return _runs.size();
+    }
+
+    std::size_t register_count() const noexcept
+    {
+        return _registers.size();
+    }
+
+private:
+    using register_id = std::uint32_t;
+
+    enum class opcode : std::uint8_t
+    {
+        sum,
+        sub,
+        product,
+        frac
+    };
+
+    struct instruction
+    {
+        register_id result;
+        register_id operand1;
+        register_id operand2;
+    };
+
+    //  Instructions [begin, end[ of the tape, all applying code
+    struct instruction_run
+    {
+        opcode code;
+        std::uint32_t begin;
+        std::uint32_t end;
+    };
+
+    template <typename Operator>
+    static void run(T* registers, const instruction* instructions, const instruction_run& r, const Operator& op) noexcept
+    {
+        for (auto i = r.begin; i != r.end; ++i)
+            registers[instructions[i].result] =
+                op(registers[instructions[i].operand1], registers[instructions[i].operand2]);
+    }
+
+    class compiler
+    {
+
+    public:
+        compiler(const expression_graph& graph, evaluation_tape& tape)
+        :   _graph{graph}, _tape{tape}
+        {}
+
+        void compile(const std::vector<node_id>& outputs)
+        {
+            _visited.assign(_graph.size(), false);
+            _depths.assign(_graph.size(), 0u);
+            for (const auto output : outputs)
+                visit(output);
+
+            //  Variables and constants first, then the temporaries
+            _registers.assign(_graph.size(), 0u);
+            register_id register_count = static_cast<register_id>(_graph.variable_count());
+            std::vector<T> constants{};
+
+            for (const auto id : _leaves) {
+                const auto& n = _graph[id];
+                if (n.kind == expression_graph::node_kind::variable) {
+                    _registers[id] = n.operand1;
+                }
+                else {
+                    _registers[id] = register_count++;
+                    constants.push_back(static_cast<T>(n.value));
+                }
+            }
+            const auto first_temporary = register_count;
+
+            //  Operands are less deep than the operations using them
+            std::stable_sort(_operations.begin(), _operations.end(),
+                [this](node_id id1, node_id id2)
+                {
+                    return
+                        (_depths[id1] != _depths[id2]) ?
+                            _depths[id1] < _depths[id2] :
+                            to_opcode(_graph[id1].kind) < to_opcode(_graph[id2].kind);
+                });
+
+            //  Last position reading each node, outputs being never released
+            std::vector<std::size_t> last_use(_graph.size(), 0u);
+            for (std::size_t position = 0u; position < _operations.size(); ++position) {
+                const auto& n = _graph[_operations[position]];
+                last_use[n.operand1] = position;
+                last_use[n.operand2] = position;
+            }
+            for (const auto output : outputs)
+                last_use[output] = never_released;
+
+            std::vector<register_id> free_registers{};
+            for (std::size_t position = 0u; position < _operations.size(); ++position) {
+                const auto id = _operations[position];
+                const auto& n = _graph[id];
+
+                //  Operands read for the last time : their registers can hold the result
+                for (const auto operand : {n.operand1, n.operand2}) {
+                    if (last_use[operand] == position && _registers[operand] >= first_temporary)
+                        free_registers.push_back(_registers[operand]);
+                    if (n.operand1 == n.operand2)
+                        break;
+                }
+
+                register_id result;
+                if (free_registers.empty()) {
+                    result = register_count++;
+                }
+                else {
+                    result = free_registers.back();
+                    free_registers.pop_back();
+                }
+
+                const auto code = to_opcode(n.kind);
+                const auto index = static_cast<std::uint32_t>(_tape._instructions.size());
+                if (_tape._runs.empty() || _tape._runs.back().code != code || is_new_depth(position))
+                    _tape._runs.push_back(instruction_run{code, index, index});
+                ++_tape._runs.back().end;
+
+                _tape._instructions.push_back(instruction{result, _registers[n.operand1], _registers[n.operand2]});
+                _registers[id] = result;
+            }
+
+            _tape._registers.assign(register_count, T{0});
+            std::copy(constants.begin(), constants.end(), _tape._registers.begin() + _graph.variable_count());
+            for (const auto output : outputs)
+                _tape._outputs.push_back(_registers[output]);
+        }
+
+    private:
+        static constexpr auto never_released = std::numeric_limits<std::size_t>::max();
+
+        static bool is_operation(const expression_graph::node& n) noexcept
+        {
+            return
+                n.kind != expression_graph::node_kind::constant &&
+                n.kind != expression_graph::node_kind::variable;
+        }
+
+        static opcode to_opcode(expression_graph::node_kind kind) noexcept
+        {
+            switch (kind) {
+            case expression_graph::node_kind::sum:      return opcode::sum;
+            case expression_graph::node_kind::sub:      return opcode::sub;
+            case expression_graph::node_kind::product:  return opcode::product;
+            default:                                    return opcode::frac;
+            }
+        }
+
+        bool is_new_depth(std::size_t position) const noexcept
+        {
+            return position == 0u || _depths[_operations[position]] != _depths[_operations[position - 1u]];
+        }
+
+        /*
+         *  Collect the leaves and the operations, with their depth, in
+         *  post-order. The stack is explicit, formulas of any length being
+         *  chains of operations as deep as them.
+         */
+        void visit(node_id root)
+        {
+            //  Node, and whether its operands were visited
+            std::vector<std::pair<node_id, bool>> stack{{root, false}};
+
+            while (!stack.empty()) {
+                const auto [id, operands_visited] = stack.back();
+                stack.pop_back();
+                const auto& n = _graph[id];
+
+                if (operands_visited) {
+                    _depths[id] = std::max(_depths[n.operand1], _depths[n.operand2]) + 1u;
+                    _operations.push_back(id);
+                }
+                else if (!_visited[id]) {
+                    _visited[id] = true;
+
+                    if (is_operation(n)) {
+                        stack.emplace_back(id, true);
+                        stack.emplace_back(n.operand2, false);
+                        stack.emplace_back(n.operand1, false);
+                    }
+                    else {
+                        _leaves.push_back(id);
+                    }
+                }
+            }
+        }
+
+        const expression_graph& _graph;
+        evaluation_tape& _tape;
+        std::vector<bool> _visited{};
+        std::vector<unsigned int> _depths{};
+        std::vector<node_id> _leaves{};
+        std::vector<node_id> _operations{};
+        std::vector<register_id> _registers{};
+    };
+
+    std::vector<instruction> _instructions{};
+    std::vector<instruction_run> _runs{};
+    std::vector<T> _registers{};
+    std::vector<register_id> _outputs{};
+};
+
+#endif /* EVALUATION_TAPE_H_ */
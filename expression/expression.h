@@ -51,7 +51,7 @@ struct operation : expression<operation<Operator, E1, E2>>
 };
 
 template <typename Operator, typename E1, typename E2>
-auto make_operation(const expression<E1>& e1, const expression<E2>& e2)
+constexpr auto make_operation(const expression<E1>& e1, const expression<E2>& e2)
 {
     return operation<Operator, E1, E2>{e1, e2};
 }
@@ -182,7 +182,7 @@ constexpr auto operator/(const constexpr_constant<T, Value>& cst, const expressi
     if constexpr (Value == 0)
         return cst;
     else
-        return operation<frac_operation, E, constexpr_constant<T, Value>>{cst, e};
+        return operation<frac_operation, constexpr_constant<T, Value>, E>{cst, e};
 }
 
 template <typename T1, T1 Value1, typename T2, T2 Value2>
@@ -0,0 +1,357 @@
+#ifndef HORNER_H_
+#define HORNER_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+#include "expression.h"
+#include "simplify.h"
+#include "../utils/type_list.h"
+
+/*
+ *  Horner form : rewrite a polynomial in its variables so that it is
+ *  evaluated with a chain of multiply-adds, which the compiler contracts
+ *  into FMA instructions :
+ *
+ *      c3 x^3 y + c1 x y^2 + c0 y^2    ->  ((c3 y) x^2 + c1 y^2) x + c0 y^2
+ *                                      ->  ((c3 * y) * x * x + c1 * (y * y)) * x + c0 * (y * y)
+ *
+ *  The expression is expanded into monomials, grouped by power of the
+ *  first variable, each group being rewritten recursively for the next
+ *  variables. The lowest power of a variable is factored out as a product
+ *  of variables only (y * y above), which the common subexpression
+ *  elimination shares between all the coefficients.
+ *
+ *  Only sums, differences and products of variables and numeric values,
+ *  possibly divided by a runtime constant, are rewritten. Other expressions
+ *  are left as they are.
+ */
+
+template <typename E>
+struct is_horner_expandable : std::bool_constant<is_numeric_v<E>> {};
+
+template <typename E>
+constexpr auto is_horner_expandable_v = is_horner_expandable<E>::value;
+
+template <typename Tag>
+struct is_horner_expandable<variable<Tag>> : std::true_type {};
+
+template <typename Operator, typename E1, typename E2>
+struct is_horner_expandable<operation<Operator, E1, E2>>
+:   std::bool_constant<
+        !std::is_same_v<Operator, frac_operation> &&
+        is_horner_expandable_v<E1> && is_horner_expandable_v<E2>>
+{};
+
+//  Only divisions by a floating point runtime constant are folded into the
+//  coefficients : an integer divisor (constant or constexpr_constant) could
+//  fold into an integer division, e.g. 1 / 2 = 0 in tau / 2.
+template <typename E, typename T>
+struct is_horner_expandable<operation<frac_operation, E, constant<T>>>
+:   std::bool_constant<std::is_floating_point_v<T> && is_horner_expandable_v<E>>
+{};
+
+/**
+ *  Numeric coefficient times the variables raised to Exponents, in the
+ *  order of the variable list
+ */
+template <typename C, unsigned int ...Exponents>
+struct horner_monomial
+{
+    static constexpr std::array<unsigned int, sizeof...(Exponents)> exponents{Exponents...};
+    C coefficient;
+};
+
+template <typename Tvars>
+struct horner_rewriter;
+
+template <typename ...Tags>
+struct horner_rewriter<type_list<Tags...>>
+{
+    template <typename E>
+    static constexpr auto rewrite(const E& e)
+    {
+        if constexpr (is_numeric_v<E> || !is_horner_expandable_v<E>)
+            return e;
+        else
+            return build<0u>(expand(e));
+    }
+
+private:
+    static constexpr auto variable_count = sizeof...(Tags);
+
+    template <unsigned int Index>
+    using variable_at = variable<std::tuple_element_t<Index, std::tuple<Tags...>>>;
+
+    template <typename Tag>
+    static constexpr unsigned int zero_exponent = 0u;
+
+    //  Expression -> tuple of monomials
+
+    template <typename E>
+    static constexpr auto expand(const E& e)
+    {
+        if constexpr (is_numeric_v<E>) {
+            return std::tuple{horner_monomial<E, zero_exponent<Tags>...>{e}};
+        }
+        else if constexpr (!operation_traits<E>::is_operation) {
+            return std::tuple{horner_monomial<constexpr_constant<int, 1>, (std::is_same_v<E, variable<Tags>> ? 1u : 0u)...>{}};
+        }
+        else {
+            using operator_type = typename operation_traits<E>::operator_type;
+
+            if constexpr (std::is_same_v<operator_type, sum_operation>)
+                return merge(std::tuple_cat(expand(e.operand1), expand(e.operand2)));
+            else if constexpr (std::is_same_v<operator_type, sub_operation>)
+                return merge(std::tuple_cat(
+                    expand(e.operand1),
+                    fold_coefficients<product_operation>(expand(e.operand2), constexpr_constant<int, -1>{})));
+            else if constexpr (std::is_same_v<operator_type, product_operation>)
+                return merge(multiply(expand(e.operand1), expand(e.operand2)));
+            else
+                return fold_coefficients<frac_operation>(expand(e.operand1), e.operand2);
+        }
+    }
+
+    template <typename Operator, typename ...M, typename N>
+    static constexpr auto fold_coefficients(const std::tuple<M...>& monomials, const N& value)
+    {
+        return std::apply(
+            [&value](const auto& ...m) { return std::tuple{fold_coefficient<Operator>(m, value)...}; },
+            monomials);
+    }
+
+    template <typename Operator, typename C, unsigned int ...Exponents, typename N>
+    static constexpr auto fold_coefficient(const horner_monomial<C, Exponents...>& m, const N& value)
+    {
+        const auto coefficient = fold_numeric<Operator>(m.coefficient, value);
+        return horner_monomial<std::decay_t<decltype(coefficient)>, Exponents...>{coefficient};
+    }
+
+    //  Monomial i * n2 + j of the product is p1[i] * p2[j]
+    template <typename ...M1, typename ...M2>
+    static constexpr auto multiply(const std::tuple<M1...>& p1, const std::tuple<M2...>& p2)
+    {
+        return multiply_impl(p1, p2, std::make_index_sequence<sizeof...(M1) * sizeof...(M2)>{});
+    }
+
+    template <typename ...M1, typename ...M2, std::size_t ...Indexes>
+    static constexpr auto multiply_impl(
+        const std::tuple<M1...>& p1, const std::tuple<M2...>& p2, const std::index_sequence<Indexes...>&)
+    {
+        constexpr auto size2 = sizeof...(M2);
+        return std::tuple{monomial_product(std::get<Indexes / size2>(p1), std::get<Indexes % size2>(p2))...};
+    }
+
+    template <typename C1, unsigned int ...Exponents1, typename C2, unsigned int ...Exponents2>
+    static constexpr auto monomial_product(
+        const horner_monomial<C1, Exponents1...>& m1, const horner_monomial<C2, Exponents2...>& m2)
+    {
+        const auto coefficient = fold_numeric<product_operation>(m1.coefficient, m2.coefficient);
+        return horner_monomial<std::decay_t<decltype(coefficient)>, (Exponents1 + Exponents2)...>{coefficient};
+    }
+
+    /*
+     *  Merge the monomials with the same exponents, so that the products of
+     *  the next steps do not grow with duplicates. A merged monomial takes the
+     *  place of the first one with its exponents.
+     */
+    template <typename ...M>
+    static constexpr auto merge(const std::tuple<M...>& monomials)
+    {
+        if constexpr (distinct_count<M...>() == sizeof...(M))
+            return monomials;
+        else
+            return merge_impl(monomials, std::make_index_sequence<distinct_count<M...>()>{});
+    }
+
+    template <typename ...M, std::size_t ...Ranks>
+    static constexpr auto merge_impl(const std::tuple<M...>& monomials, const std::index_sequence<Ranks...>&)
+    {
+        return std::tuple{merge_same<distinct_position<M...>(Ranks)>(
+            monomials, std::make_index_sequence<same_count<distinct_position<M...>(Ranks), M...>()>{})...};
+    }
+
+    template <std::size_t Position, typename ...M, std::size_t ...Ranks>
+    static constexpr auto merge_same(const std::tuple<M...>& monomials, const std::index_sequence<Ranks...>&)
+    {
+        const auto& first = std::get<Position>(monomials);
+        return with_coefficient(first, sum_coefficients(std::get<same_position<Position, M...>(Ranks)>(monomials).coefficient...));
+    }
+
+    template <typename C1, unsigned int ...Exponents, typename C2>
+    static constexpr auto with_coefficient(const horner_monomial<C1, Exponents...>&, const C2& coefficient)
+    {
+        return horner_monomial<C2, Exponents...>{coefficient};
+    }
+
+    template <typename ...M>
+    static constexpr auto all_exponents()
+    {
+        return std::array<std::array<unsigned int, variable_count>, sizeof...(M)>{M::exponents...};
+    }
+
+    template <typename ...M>
+    static constexpr bool same_exponents(std::size_t i, std::size_t j)
+    {
+        constexpr auto exponents = all_exponents<M...>();
+        for (std::size_t k = 0u; k < variable_count; ++k)
+            if (exponents[i][k] != exponents[j][k])
+                return false;
+        return true;
+    }
+
+    template <typename ...M>
+    static constexpr bool is_distinct(std::size_t i)
+    {
+        for (std::size_t j = 0u; j < i; ++j)
+            if (same_exponents<M...>(i, j))
+                return false;
+        return true;
+    }
+
+    template <typename ...M>
+    static constexpr std::size_t distinct_count()
+    {
+        std::size_t count = 0u;
+        for (std::size_t i = 0u; i < sizeof...(M); ++i)
+            count += is_distinct<M...>(i) ? 1u : 0u;
+        return count;
+    }
+
+    //  Position of the rank-th distinct monomial
+    template <typename ...M>
+    static constexpr std::size_t distinct_position(std::size_t rank)
+    {
+        std::size_t position = 0u;
+        for (; position < sizeof...(M); ++position)
+            if (is_distinct<M...>(position) && rank-- == 0u)
+                break;
+        return position;
+    }
+
+    template <std::size_t Position, typename ...M>
+    static constexpr std::size_t same_count()
+    {
+        std::size_t count = 0u;
+        for (std::size_t i = 0u; i < sizeof...(M); ++i)
+            count += same_exponents<M...>(Position, i) ? 1u : 0u;
+        return count;
+    }
+
+    //  Position of the rank-th monomial with the exponents of the one at Position
+    template <std::size_t Position, typename ...M>
+    static constexpr std::size_t same_position(std::size_t rank)
+    {
+        std::size_t position = 0u;
+        for (; position < sizeof...(M); ++position)
+            if (same_exponents<M...>(Position, position) && rank-- == 0u)
+                break;
+        return position;
+    }
+
+    //  Monomials -> Horner form in the variables from Index
+
+    template <unsigned int Index, typename ...M>
+    static constexpr auto build(const std::tuple<M...>& monomials)
+    {
+        if constexpr (Index == variable_count) {
+            //  Same exponents everywhere : only the coefficients remain
+            return std::apply([](const auto& ...m) { return sum_coefficients(m.coefficient...); }, monomials);
+        }
+        else {
+            constexpr auto low = std::min({M::exponents[Index]...});
+            constexpr auto high = std::max({M::exponents[Index]...});
+            return multiply_power<Index, low>(horner<Index, low, high>(monomials));
+        }
+    }
+
+    //  (...(c(high) x + c(high - 1)) x + ...) x + c(Degree)
+    template <unsigned int Index, unsigned int Degree, unsigned int High, typename ...M>
+    static constexpr auto horner(const std::tuple<M...>& monomials)
+    {
+        const auto group = select<Index, Degree>(monomials);
+        constexpr auto group_size = std::tuple_size_v<std::decay_t<decltype(group)>>;
+
+        if constexpr (Degree == High) {
+            return build<Index + 1u>(group);
+        }
+        else {
+            const auto higher = horner<Index, Degree + 1u, High>(monomials) * variable_at<Index>{};
+            if constexpr (group_size == 0u)
+                return higher;
+            else
+                return higher + build<Index + 1u>(group);
+        }
+    }
+
+    //  Monomials whose exponent of variable Index is Degree
+    template <unsigned int Index, unsigned int Degree, typename ...M>
+    static constexpr auto select(const std::tuple<M...>& monomials)
+    {
+        constexpr auto size = (0u + ... + (M::exponents[Index] == Degree ? 1u : 0u));
+        return select_impl<Index, Degree>(monomials, std::make_index_sequence<size>{});
+    }
+
+    template <unsigned int Index, unsigned int Degree, typename ...M, std::size_t ...Ranks>
+    static constexpr auto select_impl(const std::tuple<M...>& monomials, const std::index_sequence<Ranks...>&)
+    {
+        return std::tuple<std::tuple_element_t<select_position<Index, Degree, M...>(Ranks), std::tuple<M...>>...>{
+            std::get<select_position<Index, Degree, M...>(Ranks)>(monomials)...};
+    }
+
+    //  Position of the rank-th selected monomial
+    template <unsigned int Index, unsigned int Degree, typename ...M>
+    static constexpr std::size_t select_position(std::size_t rank)
+    {
+        constexpr std::array<unsigned int, sizeof...(M)> exponents{M::exponents[Index]...};
+        std::size_t position = 0u;
+        for (; position < exponents.size(); ++position)
+            if (exponents[position] == Degree && rank-- == 0u)
+                break;
+        return position;
+    }
+
+    //  e * x^Power, the power being a product of the variable only
+    template <unsigned int Index, unsigned int Power, typename E>
+    static constexpr auto multiply_power(const E& e)
+    {
+        if constexpr (Power == 0u)
+            return e;
+        else
+            return e * power<Index, Power>();
+    }
+
+    template <unsigned int Index, unsigned int Power>
+    static constexpr auto power()
+    {
+        if constexpr (Power == 1u)
+            return variable_at<Index>{};
+        else
+            return power<Index, Power - 1u>() * variable_at<Index>{};
+    }
+
+    template <typename C>
+    static constexpr auto sum_coefficients(const C& c)
+    {
+        return c;
+    }
+
+    template <typename C1, typename C2, typename ...C>
+    static constexpr auto sum_coefficients(const C1& c1, const C2& c2, const C& ...c)
+    {
+        return sum_coefficients(fold_numeric<sum_operation>(c1, c2), c...);
+    }
+};
+
+template <typename E, typename ...Tags>
+constexpr auto horner_form(const expression<E>& e, const type_list<Tags...>&)
+{
+    return horner_rewriter<type_list<Tags...>>::rewrite(static_cast<const E&>(e));
+}
+
+#endif /* HORNER_H_ */
@@ -0,0 +1,393 @@
+#ifndef RUNTIME_EXPRESSION_H_
+#define RUNTIME_EXPRESSION_H_
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+/**
+ *  Runtime expressions, for transfert functions only known at runtime
+ *  (e.g. read from a configuration file).
+ *
+ *  Nodes are stored once in a graph : building a node equal to an existing
+ *  one returns the existing id, so that common subexpressions are shared,
+ *  as the common subexpression elimination does for expression templates.
+ *  Constants are folded and the neutral elements removed while building.
+ */
+class expression_graph
+{
+
+public:
+    using node_id = std::uint32_t;
+
+    enum class node_kind : std::uint8_t
+    {
+        constant,
+        variable,
+        sum,
+        sub,
+        product,
+        frac
+    };
+
+    //  A variable node keeps its variable index in operand1
+    struct node
+    {
+        node_kind kind;
+        node_id operand1;
+        node_id operand2;
+        double value;
+    };
+
+    node_id constant(double value)
+    {
+        return insert(node{node_kind::constant, 0u, 0u, value});
+    }
+
+    node_id variable(std::string_view name)
+    {
+        return insert(node{node_kind::variable, variable_index(name), 0u, 0.0});
+    }
+
+    node_id sum(node_id a, node_id b)
+    {
+        if (is_constant(a) && is_constant(b))
+            return constant(value(a) + value(b));
+        else if (is_constant(a, 0.0))
+            return b;
+        else if (is_constant(b, 0.0))
+            return a;
+        else
+            return insert(node{node_kind::sum, std::min(a, b), std::max(a, b), 0.0});
+    }
+
+    node_id sub(node_id a, node_id b)
+    {
+        if (is_constant(a) && is_constant(b))
+            return constant(value(a) - value(b));
+        else if (is_constant(b, 0.0))
+            return a;
+        else if (a == b)
+            return constant(0.0);
+        else if (is_constant(a, 0.0))
+            return product(constant(-1.0), b);
+        else
+            return insert(node{node_kind::sub, a, b, 0.0});
+    }
+
+    node_id product(node_id a, node_id b)
+    {
+        if (is_constant(a) && is_constant(b))
+            return constant(value(a) * value(b));
+        else if (is_constant(a, 0.0) || is_constant(b, 0.0))
+            return constant(0.0);
+        else if (is_constant(a, 1.0))
+            return b;
+        else if (is_constant(b, 1.0))
+            return a;
+        else
+            return insert(node{node_kind::product, std::min(a, b), std::max(a, b), 0.0});
+    }
+
+    node_id frac(node_id a, node_id b)
+    {
+        if (is_constant(a) && is_constant(b))
+            return constant(value(a) / value(b));
+        else if (is_constant(a, 0.0))
+            return constant(0.0);
+        else if (is_constant(b, 1.0))
+            return a;
+        else
+            return insert(node{node_kind::frac, a, b, 0.0});
+    }
+
+    const node& operator[](node_id id) const noexcept
+    {
+        return _nodes[id];
+    }
+
+    bool is_constant(node_id id) const noexcept
+    {
+        return _nodes[id].kind == node_kind::constant;
+    }
+
+    bool is_constant(node_id id, double value) const noexcept
+    {
+        return is_constant(id) && _nodes[id].value == value;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return _nodes.size();
+    }
+
+    //  Index of a variable, added if it was not known yet
+    node_id variable_index(std::string_view name)
+    {
+        const auto it = _variable_indexes.find(std::string{name});
+        if (it != _variable_indexes.end())
+            return it->second;
+
+        const auto index = static_cast<node_id>(_variable_names.size());
+        _variable_names.emplace_back(name);
+        _variable_indexes.emplace(_variable_names.back(), index);
+        return index;
+    }
+
+    bool has_variable(std::string_view name) const
+    {
+        return _variable_indexes.count(std::string{name}) != 0u;
+    }
+
+    std::size_t variable_count() const noexcept
+    {
+        return _variable_names.size();
+    }
+
+    const std::string& variable_name(std::size_t index) const
+    {
+        return _variable_names[index];
+    }
+
+private:
+    double value(node_id id) const noexcept
+    {
+        return _nodes[id].value;
+    }
+
+    struct node_hash
+    {
+        std::size_t operator()(const node& n) const noexcept
+        {
+            std::uint64_t bits;
+            std::memcpy(&bits, &n.value, sizeof(bits));
+
+            std::size_t hash = static_cast<std::size_t>(n.kind);
+            for (const std::uint64_t field : {std::uint64_t{n.operand1}, std::uint64_t{n.operand2}, bits})
+                hash = hash * 1000003u ^ std::hash<std::uint64_t>{}(field);
+            return hash;
+        }
+    };
+
+    //  Constants are compared by their bits : 0.0 and -0.0 stay distinct
+    struct node_equal
+    {
+        bool operator()(const node& n1, const node& n2) const noexcept
+        {
+            return
+                n1.kind == n2.kind && n1.operand1 == n2.operand1 && n1.operand2 == n2.operand2 &&
+                std::memcmp(&n1.value, &n2.value, sizeof(double)) == 0;
+        }
+    };
+
+    node_id insert(const node& n)
+    {
+        const auto it = _node_ids.find(n);
+        if (it != _node_ids.end())
+            return it->second;
+
+        const auto id = static_cast<node_id>(_nodes.size());
+        _nodes.push_back(n);
+        _node_ids.emplace(n, id);
+        return id;
+    }
+
+    std::vector<node> _nodes{};
+    std::unordered_map<node, node_id, node_hash, node_equal> _node_ids{};
+    std::vector<std::string> _variable_names{};
+    std::unordered_map<std::string, node_id> _variable_indexes{};
+};
+
+/**
+ *  Parse a formula into graph. The grammar is the one of expression
+ *  templates, with integer powers :
+ *
+ *      sum     := product (('+' | '-') product)*
+ *      product := unary (('*' | '/') unary)*
+ *      unary   := '-' unary | power
+ *      power   := primary ('^' integer)?     integer <= max_exponent
+ *      primary := number | name | '(' sum ')'
+ *
+ *  Names are [A-Za-z_][A-Za-z0-9_]*. Throws std::invalid_argument on
+ *  a syntax error, with its position in the formula. Parentheses and
+ *  unary minus nest max_depth levels deep at most, so that the recursion
+ *  stays bounded on untrusted formulas.
+ */
+class expression_parser
+{
+
+public:
+    using node_id = expression_graph::node_id;
+
+    static constexpr std::size_t max_depth = 256u;
+    static constexpr unsigned int max_exponent = 64u;
+
+    static node_id parse(expression_graph& graph, std::string_view formula)
+    {
+        expression_parser parser{graph, formula};
+
+        const auto root = parser.parse_sum();
+        parser.skip_spaces();
+        if (parser._position != formula.size())
+            parser.error("unexpected character");
+        return root;
+    }
+
+private:
+    expression_parser(expression_graph& graph, std::string_view formula)
+    :   _graph{graph}, _formula{formula}
+    {}
+
+    node_id parse_sum()
+    {
+        auto result = parse_product();
+
+        for (;;) {
+            if (accept('+'))
+                result = _graph.sum(result, parse_product());
+            else if (accept('-'))
+                result = _graph.sub(result, parse_product());
+            else
+                return result;
+        }
+    }
+
+    node_id parse_product()
+    {
+        auto result = parse_unary();
+
+        for (;;) {
+            if (accept('*'))
+                result = _graph.product(result, parse_unary());
+            else if (accept('/'))
+                result = _graph.frac(result, parse_unary());
+            else
+                return result;
+        }
+    }
+
+    //  Every recursion ('-' unary and '(' sum ')') goes through parse_unary
+    node_id parse_unary()
+    {
+        if (++_depth > max_depth)
+            error("formula nested too deep");
+
+        const auto result =
+            accept('-') ?
+                _graph.product(_graph.constant(-1.0), parse_unary()) :
+                parse_power();
+
+        --_depth;
+        return result;
+    }
+
+    //  x^n as a left-leaning product chain, as written x * x * ... * x
+    node_id parse_power()
+    {
+        const auto base = parse_primary();
+        if (!accept('^'))
+            return base;
+
+        skip_spaces();
+        unsigned int exponent = 0u;
+        const auto [end, error_code] =
+            std::from_chars(_formula.data() + _position, _formula.data() + _formula.size(), exponent);
+        if (error_code != std::errc{})
+            error("expected an unsigned integer exponent");
+        if (exponent > max_exponent)
+            error("exponent too large");
+        _position = static_cast<std::size_t>(end - _formula.data());
+
+        auto result = _graph.constant(1.0);
+        for (auto i = 0u; i < exponent; ++i)
+            result = _graph.product(result, base);
+        return result;
+    }
+
+    node_id parse_primary()
+    {
+        skip_spaces();
+        if (_position == _formula.size())
+            error("unexpected end of formula");
+
+        const char c = _formula[_position];
+        if (accept('(')) {
+            const auto result = parse_sum();
+            if (!accept(')'))
+                error("expected ')'");
+            return result;
+        }
+        else if (is_name_start(c)) {
+            const auto begin = _position;
+            while (_position < _formula.size() && is_name_char(_formula[_position]))
+                ++_position;
+            return _graph.variable(_formula.substr(begin, _position - begin));
+        }
+        else if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            double value = 0.0;
+            const auto [end, error_code] =
+                std::from_chars(_formula.data() + _position, _formula.data() + _formula.size(), value);
+            if (error_code != std::errc{})
+                error("invalid number");
+            _position = static_cast<std::size_t>(end - _formula.data());
+            return _graph.constant(value);
+        }
+        else {
+            error("expected a number, a name or '('");
+        }
+    }
+
+    bool accept(char c)
+    {
+        skip_spaces();
+        if (_position < _formula.size() && _formula[_position] == c) {
+            ++_position;
+            return true;
+        }
+        return false;
+    }
+
+    void skip_spaces()
+    {
+        while (_position < _formula.size() && std::isspace(static_cast<unsigned char>(_formula[_position])))
+            ++_position;
+    }
+
+    static bool is_name_start(char c)
+    {
+        return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    static bool is_name_char(char c)
+    {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    [[noreturn]] void error(const char* message) const
+    {
+        throw std::invalid_argument{
+            std::string{message} + " at position " + std::to_string(_position) +
+            " in '" + std::string{_formula} + "'"};
+    }
+
+    expression_graph& _graph;
+    std::string_view _formula;
+    std::size_t _position{0u};
+    std::size_t _depth{0u};
+};
+
+inline expression_graph::node_id parse_expression(expression_graph& graph, std::string_view formula)
+{
+    return expression_parser::parse(graph, formula);
+}
+
+#endif /* RUNTIME_EXPRESSION_H_ */
@@ -0,0 +1,221 @@
+#ifndef SIMPLIFY_H_
+#define SIMPLIFY_H_
+
+#include <limits>
+#include <type_traits>
+
+#include "expression.h"
+#include "evaluate.h"
+#include "common_subexpression.h"
+#include "../utils/type_list.h"
+#include "../utils/variable_set.h"
+
+/*
+ *  Simplify : rebuild an expression bottom-up in a canonical form
+ *
+ *      - numeric operands are folded, runtime constants included
+ *      - x + 0, x - 0, x * 1, x * 0, x / 1, 0 / x are removed
+ *      - x - x and x / x are folded when x only holds variables and constexpr constants
+ *      - sums and products are flattened into left-leaning chains whose terms
+ *        are sorted by the rank of their first variable in a variable order,
+ *        numeric terms last and folded together, x + x becoming x * 2
+ *
+ *  Two expressions that only differ by the order of their terms then have
+ *  the same type, which exposes them to the common subexpression elimination.
+ */
+
+template <typename E>
+struct operation_traits
+{
+    static constexpr bool is_operation = false;
+};
+
+template <typename Operator, typename E1, typename E2>
+struct operation_traits<operation<Operator, E1, E2>>
+{
+    static constexpr bool is_operation = true;
+    using operator_type = Operator;
+};
+
+template <typename E, typename Operator>
+constexpr auto is_operation_of_v = false;
+
+template <typename Operator, typename E1, typename E2>
+constexpr auto is_operation_of_v<operation<Operator, E1, E2>, Operator> = true;
+
+template <typename E>
+constexpr auto is_constexpr_constant_v = false;
+
+template <typename T, T Value>
+constexpr auto is_constexpr_constant_v<constexpr_constant<T, Value>> = true;
+
+template <typename E>
+constexpr auto is_numeric_v = is_constexpr_constant_v<E>;
+
+template <typename T>
+constexpr auto is_numeric_v<constant<T>> = true;
+
+template <typename E, int V>
+constexpr auto is_constexpr_value_v = false;
+
+template <typename T, T Value, int V>
+constexpr auto is_constexpr_value_v<constexpr_constant<T, Value>, V> = (Value == V);
+
+/**
+ *  Fold two numeric values into one, a constexpr_constant when both are
+ */
+template <typename Operator, typename E1, typename E2>
+constexpr auto fold_numeric(const E1& e1, const E2& e2)
+{
+    if constexpr (is_constexpr_constant_v<E1> && is_constexpr_constant_v<E2>)
+        return constexpr_constant<
+            decltype(apply_operation<Operator>(E1::value, E2::value)),
+            apply_operation<Operator>(E1::value, E2::value)>{};
+    else
+        return constant{apply_operation<Operator>(evaluate(e1), evaluate(e2))};
+}
+
+/*
+ *  Rank used to sort terms : variable position in Tvars, numeric values last
+ */
+
+template <typename E, typename Tvars>
+struct simplify_rank;
+
+template <typename E, typename Tvars>
+constexpr auto simplify_rank_v = simplify_rank<E, Tvars>::value;
+
+template <typename Tag, typename ...Tags>
+struct simplify_rank<variable<Tag>, type_list<Tags...>>
+{
+    //  Variables missing from the order come after the others
+    static constexpr auto value = type_list_index_of_v<type_list<Tags..., Tag>, Tag>;
+};
+
+template <typename T, typename Tvars>
+struct simplify_rank<constant<T>, Tvars>
+{
+    static constexpr auto value = std::numeric_limits<unsigned int>::max();
+};
+
+template <typename T, T Value, typename Tvars>
+struct simplify_rank<constexpr_constant<T, Value>, Tvars>
+{
+    static constexpr auto value = std::numeric_limits<unsigned int>::max();
+};
+
+template <typename Operator, typename E1, typename E2, typename Tvars>
+struct simplify_rank<operation<Operator, E1, E2>, Tvars>
+{
+    static constexpr auto value = simplify_rank_v<E1, Tvars>;
+};
+
+/**
+ *  Simplification rules, for a given variable order
+ */
+template <typename Tvars>
+struct simplifier
+{
+    template <typename E>
+    static constexpr auto simplify(const E& e)
+    {
+        if constexpr (operation_traits<E>::is_operation)
+            return combine<typename operation_traits<E>::operator_type>(
+                simplify(e.operand1), simplify(e.operand2));
+        else
+            return e;
+    }
+
+private:
+    template <typename Operator, typename E1, typename E2>
+    static constexpr auto make(const E1& e1, const E2& e2)
+    {
+        return operation<Operator, E1, E2>{e1, e2};
+    }
+
+    template <typename Operator, typename E1, typename E2>
+    static constexpr auto fold(const E1& e1, const E2& e2)
+    {
+        return fold_numeric<Operator>(e1, e2);
+    }
+
+    template <typename Operator, typename E1, typename E2>
+    static constexpr auto combine(const E1& e1, const E2& e2)
+    {
+        constexpr auto same_shareable = std::is_same_v<E1, E2> && is_shareable_v<E1>;
+
+        if constexpr (is_numeric_v<E1> && is_numeric_v<E2>)
+            return fold<Operator>(e1, e2);
+        else if constexpr (std::is_same_v<Operator, sum_operation> || std::is_same_v<Operator, product_operation>)
+            return insert<Operator>(e1, e2);
+        else if constexpr (std::is_same_v<Operator, sub_operation>) {
+            if constexpr (is_constexpr_value_v<E2, 0>)
+                return e1;
+            else if constexpr (same_shareable)
+                return constexpr_constant<int, 0>{};
+            else
+                return make<Operator>(e1, e2);
+        }
+        else {
+            if constexpr (is_constexpr_value_v<E2, 1> || is_constexpr_value_v<E1, 0>)
+                return e1;
+            else if constexpr (same_shareable)
+                return constexpr_constant<int, 1>{};
+            else
+                return make<Operator>(e1, e2);
+        }
+    }
+
+    //  Insert a term in a sorted chain of Operator
+    template <typename Operator, typename Chain, typename Term>
+    static constexpr auto insert(const Chain& chain, const Term& term)
+    {
+        constexpr auto is_sum = std::is_same_v<Operator, sum_operation>;
+        constexpr auto neutral = is_sum ? 0 : 1;
+
+        if constexpr (is_operation_of_v<Term, Operator>)
+            return insert<Operator>(insert<Operator>(chain, term.operand1), term.operand2);
+        else if constexpr (is_constexpr_value_v<Term, neutral>)
+            return chain;
+        else if constexpr (!is_sum && is_constexpr_value_v<Term, 0>)
+            return term;
+        else if constexpr (is_operation_of_v<Chain, Operator>) {
+            using last_type = std::decay_t<decltype(chain.operand2)>;
+
+            if constexpr (simplify_rank_v<Term, Tvars> < simplify_rank_v<last_type, Tvars>)
+                return insert<Operator>(insert<Operator>(chain.operand1, term), chain.operand2);
+            else if constexpr (is_numeric_v<last_type> && is_numeric_v<Term>)
+                return insert<Operator>(chain.operand1, fold<Operator>(chain.operand2, term));
+            else if constexpr (is_sum && std::is_same_v<last_type, Term> && is_shareable_v<Term>)
+                return make<Operator>(chain.operand1, make<product_operation>(term, constexpr_constant<int, 2>{}));
+            else
+                return make<Operator>(chain, term);
+        }
+        else if constexpr (is_constexpr_value_v<Chain, neutral>)
+            return term;
+        else if constexpr (!is_sum && is_constexpr_value_v<Chain, 0>)
+            return chain;
+        else if constexpr (is_numeric_v<Chain> && is_numeric_v<Term>)
+            return fold<Operator>(chain, term);
+        else if constexpr (is_sum && std::is_same_v<Chain, Term> && is_shareable_v<Term>)
+            return make<product_operation>(term, constexpr_constant<int, 2>{});
+        else if constexpr (simplify_rank_v<Term, Tvars> < simplify_rank_v<Chain, Tvars>)
+            return make<Operator>(term, chain);
+        else
+            return make<Operator>(chain, term);
+    }
+};
+
+template <typename E, typename ...Tags>
+constexpr auto simplify(const expression<E>& e, const type_list<Tags...>&)
+{
+    return simplifier<type_list<Tags...>>::simplify(static_cast<const E&>(e));
+}
+
+template <typename E>
+constexpr auto simplify(const expression<E>& e)
+{
+    return simplify(e, variable_set_t<E>{});
+}
+
+#endif /* SIMPLIFY_H_ */
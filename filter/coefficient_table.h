@@ -0,0 +1,137 @@
+#ifndef COEFFICIENT_TABLE_H_
+#define COEFFICIENT_TABLE_H_
+
+#include <array>
+#include <cstddef>
+#include <limits>
+
+#include "filter_design.h"
+
+/**
+ *  Coefficient table : normalized coefficients precomputed over a regular
+ *  grid of one variable, the other variables being fixed. Lookups clamp to
+ *  the grid range and interpolate between grid points, which is much cheaper
+ *  than evaluating the design. The grid must be fine enough for the
+ *  interpolated coefficients to stay stable.
+ */
+
+enum class table_interpolation
+{
+    linear,
+    cubic       //  Catmull-Rom
+};
+
+template <typename T, unsigned int Order, std::size_t Size, table_interpolation Interpolation = table_interpolation::linear>
+class coefficient_table
+{
+    static_assert(Size >= 2u);
+    static_assert(Interpolation == table_interpolation::linear || Size >= 4u);
+
+public:
+    using value_type = T;
+    using coefficients_type = filter_coefficients<T, Order>;
+
+    static constexpr auto size = Size;
+
+    /**
+     *  Evaluate design over Size values of var in [min, max]. The design is taken
+     *  by copy, with the other variables already set.
+     */
+    template <typename Tdesign, typename SearchTag>
+    constexpr coefficient_table(Tdesign design, const variable<SearchTag>& var, const T& min, const T& max)
+    :   _min{min},
+        _inv_step{static_cast<T>(Size - 1u) / (max - min)}
+    {
+        for (auto i = 0u; i < Size; ++i) {
+            design.set_variable(var, min + (max - min) * static_cast<T>(i) / static_cast<T>(Size - 1u));
+            _coefficients[i] = design.coefficients();
+        }
+    }
+
+    constexpr coefficients_type operator()(const T& value) const
+    {
+        const T position = clamp_position((value - _min) * _inv_step);
+        const auto index = static_cast<std::size_t>(position);
+        const T fraction = position - static_cast<T>(index);
+
+        coefficients_type result{};
+
+        if constexpr (Interpolation == table_interpolation::linear) {
+            const auto& c0 = _coefficients[index];
+            const auto& c1 = _coefficients[index + 1u];
+            for (auto k = 0u; k <= Order; ++k)
+                result.feedforward[k] = linear(c0.feedforward[k], c1.feedforward[k], fraction);
+            for (auto k = 0u; k < Order; ++k)
+                result.feedback[k] = linear(c0.feedback[k], c1.feedback[k], fraction);
+        }
+        else {
+            //  At the ends of the grid, the missing neighbour is extrapolated by a parabola
+            const bool first = (index == 0u);
+            const bool last = (index + 2u == Size);
+            const auto& c0 = _coefficients[first ? index + 2u : index - 1u];
+            const auto& c1 = _coefficients[index];
+            const auto& c2 = _coefficients[index + 1u];
+            const auto& c3 = _coefficients[last ? index - 1u : index + 2u];
+
+            for (auto k = 0u; k <= Order; ++k)
+                result.feedforward[k] = cubic(first, last,
+                    c0.feedforward[k], c1.feedforward[k], c2.feedforward[k], c3.feedforward[k], fraction);
+            for (auto k = 0u; k < Order; ++k)
+                result.feedback[k] = cubic(first, last,
+                    c0.feedback[k], c1.feedback[k], c2.feedback[k], c3.feedback[k], fraction);
+        }
+
+        return result;
+    }
+
+    constexpr const coefficients_type& grid_coefficients(std::size_t index) const
+    {
+        return _coefficients[index];
+    }
+
+private:
+    //  Position in [0, Size - 1[ so that index + 1 is always valid
+    static constexpr T clamp_position(const T& position)
+    {
+        constexpr T last = static_cast<T>(Size - 1u);
+        if (!(position > T{0}))
+            return T{0};
+        else if (position >= last)
+            return last - last * std::numeric_limits<T>::epsilon();
+        else
+            return position;
+    }
+
+    static constexpr T linear(const T& y0, const T& y1, const T& x)
+    {
+        return y0 + (y1 - y0) * x;
+    }
+
+    //  When first (resp. last), y0 (resp. y3) holds the other far neighbour
+    static constexpr T cubic(bool first, bool last, T y0, const T& y1, const T& y2, T y3, const T& x)
+    {
+        if (first)
+            y0 = T{3} * (y1 - y2) + y0;
+        if (last)
+            y3 = T{3} * (y2 - y1) + y3;
+
+        const T a = T{0.5} * (y3 - y0) + T{1.5} * (y1 - y2);
+        const T b = y0 - T{2.5} * y1 + T{2} * y2 - T{0.5} * y3;
+        const T c = T{0.5} * (y2 - y0);
+        return ((a * x + b) * x + c) * x + y1;
+    }
+
+    T _min;
+    T _inv_step;
+    std::array<coefficients_type, Size> _coefficients{};
+};
+
+template <std::size_t Size, table_interpolation Interpolation = table_interpolation::linear, typename Tdesign, typename SearchTag, typename T>
+constexpr auto make_coefficient_table(const Tdesign& design, const variable<SearchTag>& var, const T& min, const T& max)
+{
+    using value_type = typename Tdesign::coefficients_type::value_type;
+    return coefficient_table<value_type, Tdesign::info::filter_order, Size, Interpolation>{
+        design, var, static_cast<value_type>(min), static_cast<value_type>(max)};
+}
+
+#endif /* COEFFICIENT_TABLE_H_ */
@@ -0,0 +1,214 @@
+#ifndef FILTER_BANK_H_
+#define FILTER_BANK_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ *  Filter bank : many independent instances of the same filter, each one
+ *  processing its own stream, spread over a pool of worker threads.
+ *
+ *  Streams are grouped in chunks, and each worker is given a contiguous
+ *  range of chunks. A worker that finished its own range steals the
+ *  remaining chunks of the others. Each instance is padded to a cache
+ *  line, so that workers never write to the same line.
+ *
+ *  process() is a barrier : the calling thread takes part in the work
+ *  as worker 0 and returns when every stream has been processed.
+ */
+template <typename Tfilter>
+class filter_bank
+{
+
+public:
+    using filter_type = Tfilter;
+    using sample_type = typename Tfilter::sample_type;
+
+    static constexpr std::size_t cache_line_size = 64u;
+    static constexpr std::size_t chunk_size = 8u;
+
+    filter_bank(
+        const Tfilter& prototype, std::size_t stream_count,
+        std::size_t thread_count = std::thread::hardware_concurrency())
+    :   _filters(stream_count, slot{prototype}),
+        _chunk_count{(stream_count + chunk_size - 1u) / chunk_size},
+        _workers(std::clamp<std::size_t>(thread_count, 1u, std::max<std::size_t>(_chunk_count, 1u)))
+    {
+        //  Worker w owns the chunks [first(w), first(w + 1)[
+        const auto worker_count = _workers.size();
+        for (std::size_t w = 0u; w < worker_count; ++w) {
+            _workers[w].first = _chunk_count * w / worker_count;
+            _workers[w].last = _chunk_count * (w + 1u) / worker_count;
+        }
+
+        _threads.reserve(worker_count - 1u);
+        for (std::size_t w = 1u; w < worker_count; ++w)
+            _threads.emplace_back([this, w]() { worker_loop(w); });
+    }
+
+    filter_bank(const filter_bank&) = delete;
+    filter_bank& operator=(const filter_bank&) = delete;
+
+    ~filter_bank()
+    {
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _stopping = true;
+        }
+        _start.notify_all();
+
+        for (auto& thread : _threads)
+            thread.join();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return _filters.size();
+    }
+
+    std::size_t thread_count() const noexcept
+    {
+        return _workers.size();
+    }
+
+    Tfilter& operator[](std::size_t stream) noexcept
+    {
+        return _filters[stream].filter;
+    }
+
+    const Tfilter& operator[](std::size_t stream) const noexcept
+    {
+        return _filters[stream].filter;
+    }
+
+    /**
+     *  Process count samples of every stream : in[i] and out[i] are the
+     *  buffers of stream i. in and out may be the same buffers.
+     */
+    void process(const sample_type* const* in, sample_type* const* out, std::size_t count)
+    {
+        _in = in;
+        _out = out;
+        _count = count;
+
+        for (auto& worker : _workers)
+            worker.next.store(worker.first, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _pending = _threads.size();
+            ++_generation;
+        }
+        _start.notify_all();
+
+        run(0u);
+
+        std::unique_lock<std::mutex> lock{_mutex};
+        _done.wait(lock, [this]() { return _pending == 0u; });
+    }
+
+    void process(sample_type* const* inout, std::size_t count)
+    {
+        process(inout, inout, count);
+    }
+
+    void reset()
+    {
+        for (auto& s : _filters)
+            s.filter.reset();
+    }
+
+private:
+    struct alignas(cache_line_size) slot
+    {
+        Tfilter filter;
+    };
+
+    struct alignas(cache_line_size) worker_range
+    {
+        std::atomic<std::size_t> next{0u};
+        std::size_t first{0u};
+        std::size_t last{0u};
+    };
+
+    void worker_loop(std::size_t worker)
+    {
+        std::size_t generation = 0u;
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock{_mutex};
+                _start.wait(lock, [&]() { return _stopping || _generation != generation; });
+                if (_stopping)
+                    return;
+                generation = _generation;
+            }
+
+            run(worker);
+
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+                if (--_pending != 0u)
+                    continue;
+            }
+            _done.notify_one();
+        }
+    }
+
+    //  Own chunks first, then the ones left by the other workers
+    void run(std::size_t worker)
+    {
+        const auto worker_count = _workers.size();
+
+        for (std::size_t i = 0u; i < worker_count; ++i) {
+            auto& range = _workers[(worker + i) % worker_count];
+
+            for (;;) {
+                const auto chunk = range.next.fetch_add(1u, std::memory_order_relaxed);
+                if (chunk >= range.last)
+                    break;
+                process_chunk(chunk);
+            }
+        }
+    }
+
+    void process_chunk(std::size_t chunk)
+    {
+        const auto begin = chunk * chunk_size;
+        const auto end = std::min(begin + chunk_size, _filters.size());
+
+        for (auto stream = begin; stream < end; ++stream)
+            _filters[stream].filter.process_block(_in[stream], _out[stream], _count);
+    }
+
+    std::vector<slot> _filters;
+    std::size_t _chunk_count;
+    std::vector<worker_range> _workers;
+    std::vector<std::thread> _threads{};
+
+    std::mutex _mutex{};
+    std::condition_variable _start{};
+    std::condition_variable _done{};
+    std::size_t _generation{0u};
+    std::size_t _pending{0u};
+    bool _stopping{false};
+
+    const sample_type* const* _in{nullptr};
+    sample_type* const* _out{nullptr};
+    std::size_t _count{0u};
+};
+
+template <typename Tfilter>
+auto make_filter_bank(
+    const Tfilter& prototype, std::size_t stream_count,
+    std::size_t thread_count = std::thread::hardware_concurrency())
+{
+    return filter_bank<Tfilter>{prototype, stream_count, thread_count};
+}
+
+#endif /* FILTER_BANK_H_ */
@@ -0,0 +1,187 @@
+#ifndef FILTER_DESIGN_H_
+#define FILTER_DESIGN_H_
+
+#include <array>
+#include <utility>
+
+#include "../bilinear_transform/rational_fraction.h"
+#include "../expression/common_subexpression.h"
+#include "../utils/type_list.h"
+#include "../utils/variable_set.h"
+#include "../utils/variable_store.h"
+
+/**
+ *
+ */
+
+template <typename Tztransform>
+struct ztransform_info;
+
+template <typename ...E1, typename ...E2>
+struct ztransform_info<rational_fraction<polynomial<E1...>, polynomial<E2...>>>
+{
+    static_assert (polynomial<E1...>::degree() <= polynomial<E2...>::degree());
+    static constexpr auto filter_order = polynomial<E2...>::degree();
+    using var_tags = variable_set_t<rational_fraction<polynomial<E1...>, polynomial<E2...>>>;
+
+    //  Subexpressions common to the coefficients, evaluated once per update
+    using shared_subexpressions = shared_subexpressions_t<E2..., E1...>;
+};
+
+/**
+ *  Numeric coefficients, normalized by a0 :
+ *
+ *      y[n] = sum(k = 0..N) feedforward[k] * x[n - k]
+ *           - sum(k = 1..N) feedback[k - 1] * y[n - k]
+ */
+template <typename T, unsigned int Order>
+struct filter_coefficients
+{
+    using value_type = T;
+
+    std::array<T, Order + 1> feedforward{};
+    std::array<T, Order> feedback{};
+};
+
+/**
+ *  Filter design : a z transfert function, the values of its
+ *  variables, and the numeric coefficients evaluated from them.
+ *  Coefficients are only re-evaluated after a variable changed.
+ */
+
+template <typename T, typename Tztransform>
+class filter_design;
+
+template <typename T, typename Pnumerator, typename Pdenominator>
+class filter_design<T, rational_fraction<Pnumerator, Pdenominator>>
+{
+
+public:
+    using Tztransform = rational_fraction<Pnumerator, Pdenominator>;
+    using info = ztransform_info<Tztransform>;
+    using coefficients_type = filter_coefficients<T, info::filter_order>;
+
+    //    variable_store_t = variable_store<T, Tags...>
+    using variable_store_t =
+        type_list_instanciate_t<
+            type_list_append_t<typename info::var_tags, T>, variable_store>;
+
+    using subexpression_cache_t = subexpression_cache<T, typename info::shared_subexpressions>;
+
+    //  Values of all the variables, in the order of info::var_tags
+    using variable_values_type = decltype(std::declval<variable_store_t>().values());
+
+    constexpr filter_design(const Tztransform& transfert_function)
+    :   _transfert_function{transfert_function}
+    {}
+
+    template <typename SearchTag>
+    constexpr void set_variable(const variable<SearchTag>&, const T& value)
+    {
+        _variable_store.template set<SearchTag>(value);
+        _coefficients_outdated = true;
+    }
+
+    template <typename SearchTag>
+    constexpr T get_variable(const variable<SearchTag>&) const
+    {
+        return _variable_store.template get<SearchTag>();
+    }
+
+    constexpr variable_values_type variable_values() const
+    {
+        return _variable_store.values();
+    }
+
+    constexpr void set_variable_values(const variable_values_type& values)
+    {
+        _variable_store.set_values(values);
+        _coefficients_outdated = true;
+    }
+
+    /**
+     *  Set all the variables with coefficients evaluated from them
+     *  beforehand (e.g. saved in a snapshot) : the coefficients are
+     *  not re-evaluated.
+     */
+    constexpr void restore(const variable_values_type& values, const coefficients_type& coefficients)
+    {
+        _variable_store.set_values(values);
+        _coefficients = coefficients;
+        _coefficients_outdated = false;
+    }
+
+    constexpr bool coefficients_outdated() const noexcept
+    {
+        return _coefficients_outdated;
+    }
+
+    constexpr const coefficients_type& coefficients()
+    {
+        if (_coefficients_outdated)
+            update_coefficients();
+        return _coefficients;
+    }
+
+    constexpr const Tztransform& transfert_function() const noexcept
+    {
+        return _transfert_function;
+    }
+
+private:
+    static constexpr auto filter_order = info::filter_order;
+
+    constexpr void update_coefficients()
+    {
+        _subexpressions.update(_variable_store);
+
+        const auto output_divider =
+            eval(std::get<filter_order>(_transfert_function.denominator.coefficients));
+        const T inv_output_divider = T{1} / static_cast<T>(output_divider);
+
+        update_feedforward(std::make_integer_sequence<unsigned int, filter_order + 1>{}, inv_output_divider);
+        update_feedback(std::make_integer_sequence<unsigned int, filter_order>{}, inv_output_divider);
+        _coefficients_outdated = false;
+    }
+
+    //  feedforward[k] = n[N - k] / d[N]
+    template <unsigned int ...Indexes>
+    constexpr void update_feedforward(
+        const std::integer_sequence<unsigned int, Indexes...>&, const T& inv_output_divider)
+    {
+        (..., (_coefficients.feedforward[Indexes] = numerator_coefficient<filter_order - Indexes>() * inv_output_divider));
+    }
+
+    //  feedback[k - 1] = d[N - k] / d[N]
+    template <unsigned int ...Indexes>
+    constexpr void update_feedback(
+        const std::integer_sequence<unsigned int, Indexes...>&, const T& inv_output_divider)
+    {
+        (..., (_coefficients.feedback[Indexes] =
+            static_cast<T>(eval(
+                std::get<filter_order - 1 - Indexes>(_transfert_function.denominator.coefficients))) * inv_output_divider));
+    }
+
+    template <unsigned int Degree>
+    constexpr T numerator_coefficient()
+    {
+        if constexpr (Degree <= Pnumerator::degree())
+            return static_cast<T>(eval(std::get<Degree>(_transfert_function.numerator.coefficients)));
+        else
+            return T{0};
+    }
+
+    template <typename E>
+    constexpr auto eval(const expression<E>& e) const
+    {
+        return _subexpressions.eval(_variable_store, e);
+    }
+
+    const Tztransform _transfert_function;
+    variable_store_t _variable_store{};
+    subexpression_cache_t _subexpressions{};
+    coefficients_type _coefficients{};
+    bool _coefficients_outdated{true};
+};
+
+#endif /* FILTER_DESIGN_H_ */
@@ -0,0 +1,435 @@
+#ifndef FILTER_GRAPH_H_
+#define FILTER_GRAPH_H_
+
+#include <cstddef>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "../bilinear_transform/bilinear_transform.h"
+#include "../utils/type_list.h"
+#include "filter_design.h"
+#include "instrumentation.h"
+#include "realization.h"
+
+/**
+ *  Filter graphs : laplace transfert functions composed in series and in
+ *  parallel, e.g. an EQ chain
+ *
+ *      series(low_shelf, parallel(peak1, peak2), high_shelf)
+ *
+ *  At compile time, adjacent stages are either fused into one transfert
+ *  function (product in series, sum in parallel), realized as one
+ *  recursion, or kept as separate filters. The fusion policy bounds the
+ *  order of a fused stage : the sensitivity of direct forms to coefficient
+ *  rounding grows with the order, so the default policy only fuses up to
+ *  second order sections.
+ *
+ *  process_block runs every stage in one loop over the samples, each output
+ *  sample going through the whole graph before the next one : there is no
+ *  intermediate buffer between stages, and the recursions of successive
+ *  stages overlap.
+ */
+
+template <typename Tsample, typename Tztransform, typename Realization, typename Instrumentation>
+struct iir_filter_implementation;
+
+/**
+ *  Fusion policies : stages are fused while the fused order is at most MaxOrder
+ */
+template <unsigned int MaxOrder>
+struct fuse_up_to_order
+{
+    static constexpr unsigned int max_order = MaxOrder;
+};
+
+using never_fuse = fuse_up_to_order<0u>;
+using always_fuse = fuse_up_to_order<std::numeric_limits<unsigned int>::max()>;
+using default_fusion_policy = fuse_up_to_order<2u>;
+
+//-   Graph description
+
+template <typename ...G>
+struct series_graph
+{
+    std::tuple<G...> stages;
+};
+
+template <typename ...G>
+struct parallel_graph
+{
+    std::tuple<G...> stages;
+};
+
+template <typename ...G>
+constexpr auto series(const G& ...stages)
+{
+    return series_graph<G...>{{stages...}};
+}
+
+template <typename ...G>
+constexpr auto parallel(const G& ...stages)
+{
+    return parallel_graph<G...>{{stages...}};
+}
+
+//-   Compile time plan : fused stages, and the series and parallel nodes left
+
+//  A transfert function realized as one filter, of order at most Order
+template <typename E, unsigned int Order>
+struct fused_stage
+{
+    static constexpr auto order = Order;
+    E laplace_transfert_function;
+};
+
+template <typename ...P>
+struct series_plan
+{
+    std::tuple<P...> stages;
+};
+
+template <typename ...P>
+struct parallel_plan
+{
+    std::tuple<P...> stages;
+};
+
+template <typename P>
+constexpr auto is_fused_stage_v = false;
+
+template <typename E, unsigned int Order>
+constexpr auto is_fused_stage_v<fused_stage<E, Order>> = true;
+
+template <typename E>
+constexpr auto laplace_filter_order =
+    ztransform_info<std::decay_t<decltype(bilinear_transform(std::declval<const E&>()))>>::filter_order;
+
+template <typename Policy>
+struct filter_graph_planner
+{
+    template <typename E>
+    static constexpr auto plan(const expression<E>& e)
+    {
+        return fused_stage<E, laplace_filter_order<E>>{e};
+    }
+
+    template <typename ...G>
+    static constexpr auto plan(const series_graph<G...>& graph)
+    {
+        return std::apply(
+            [](const auto& ...stages) { return group<series_plan>(std::tuple<>{}, std::tuple<>{}, plan(stages)...); },
+            graph.stages);
+    }
+
+    template <typename ...G>
+    static constexpr auto plan(const parallel_graph<G...>& graph)
+    {
+        return std::apply(
+            [](const auto& ...stages) { return group<parallel_plan>(std::tuple<>{}, std::tuple<>{}, plan(stages)...); },
+            graph.stages);
+    }
+
+private:
+    /*
+     *  Stages are fused from left to right into current (an empty tuple
+     *  or a fused stage) while the policy allows it, the other ones being
+     *  moved to done.
+     */
+    template <template <typename...> class Tplan, typename ...Done, typename Current>
+    static constexpr auto group(const std::tuple<Done...>& done, const Current& current)
+    {
+        const auto stages = append(done, current);
+
+        if constexpr (std::tuple_size_v<std::decay_t<decltype(stages)>> == 1u)
+            return std::get<0>(stages);
+        else
+            return std::apply([](const auto& ...s) { return Tplan<std::decay_t<decltype(s)>...>{{s...}}; }, stages);
+    }
+
+    template <template <typename...> class Tplan, typename ...Done, typename Current, typename First, typename ...Rest>
+    static constexpr auto group(const std::tuple<Done...>& done, const Current& current, const First& first, const Rest& ...rest)
+    {
+        if constexpr (is_fused_stage_v<Current> && is_fused_stage_v<First>) {
+            if constexpr (First::order <= Policy::max_order && Current::order <= Policy::max_order - First::order)
+                return group<Tplan>(done, fuse<Tplan>(current, first), rest...);
+            else
+                return group<Tplan>(append(done, current), first, rest...);
+        }
+        else if constexpr (is_fused_stage_v<First>) {
+            return group<Tplan>(append(done, current), first, rest...);
+        }
+        else {
+            return group<Tplan>(append(append(done, current), first), std::tuple<>{}, rest...);
+        }
+    }
+
+    template <template <typename...> class Tplan, typename E1, unsigned int Order1, typename E2, unsigned int Order2>
+    static constexpr auto fuse(const fused_stage<E1, Order1>& s1, const fused_stage<E2, Order2>& s2)
+    {
+        if constexpr (std::is_same_v<Tplan<>, series_plan<>>) {
+            const auto e = s1.laplace_transfert_function * s2.laplace_transfert_function;
+            return fused_stage<std::decay_t<decltype(e)>, Order1 + Order2>{e};
+        }
+        else {
+            const auto e = s1.laplace_transfert_function + s2.laplace_transfert_function;
+            return fused_stage<std::decay_t<decltype(e)>, Order1 + Order2>{e};
+        }
+    }
+
+    template <typename ...Done, typename P>
+    static constexpr auto append(const std::tuple<Done...>& done, const P& stage)
+    {
+        if constexpr (std::is_same_v<P, std::tuple<>>)
+            return done;
+        else
+            return std::tuple_cat(done, std::tuple<P>{stage});
+    }
+};
+
+//-   Filters
+
+/**
+ *  Processing shared by the graph nodes. A node provides
+ *
+ *      local_type load();                          //  Copy of the realizations, up to date
+ *      void store(const local_type&);
+ *      static Tsample step(local_type&, const Tsample&);
+ *
+ *  so that a block runs on local copies, as the realizations do.
+ */
+template <typename Derived, typename Tsample>
+class filter_graph_node
+{
+
+public:
+    using sample_type = Tsample;
+
+    Tsample process_one_sample(const Tsample& in)
+    {
+        auto local = derived().load();
+        const Tsample out = Derived::step(local, in);
+        derived().store(local);
+        return out;
+    }
+
+    //  in and out may be the same buffer
+    void process_block(const Tsample* in, Tsample* out, std::size_t count)
+    {
+        auto local = derived().load();
+        for (std::size_t i = 0u; i < count; ++i)
+            out[i] = Derived::step(local, in[i]);
+        derived().store(local);
+    }
+
+    void process_block(Tsample* inout, std::size_t count)
+    {
+        process_block(inout, inout, count);
+    }
+
+protected:
+    template <typename Node, typename SearchTag, typename T>
+    static constexpr void set_node_variable(Node& node, const variable<SearchTag>& var, const T& value)
+    {
+        if constexpr (Node::template has_variable<SearchTag>)
+            node.set_variable(var, value);
+    }
+
+private:
+    constexpr Derived& derived() noexcept
+    {
+        return static_cast<Derived&>(*this);
+    }
+};
+
+template <typename Tfilter>
+class filter_graph_leaf : public filter_graph_node<filter_graph_leaf<Tfilter>, typename Tfilter::sample_type>
+{
+
+public:
+    using filter_type = Tfilter;
+    using sample_type = typename Tfilter::sample_type;
+    using value_type = typename Tfilter::value_type;
+    using local_type = typename Tfilter::realization_type;
+
+    static constexpr auto order = Tfilter::info::filter_order;
+
+    template <typename Tag>
+    static constexpr bool has_variable = type_list_contains_v<typename Tfilter::info::var_tags, Tag>;
+
+    constexpr explicit filter_graph_leaf(const Tfilter& filter)
+    :   _filter{filter}
+    {}
+
+    template <typename SearchTag>
+    constexpr void set_variable(const variable<SearchTag>& var, const value_type& value)
+    {
+        static_assert(has_variable<SearchTag>);
+        _filter.set_variable(var, value);
+    }
+
+    constexpr const Tfilter& filter() const noexcept
+    {
+        return _filter;
+    }
+
+    constexpr void reset()
+    {
+        _filter.reset();
+    }
+
+    local_type load()
+    {
+        _filter.coefficients();
+        return _filter.realization();
+    }
+
+    void store(const local_type& local)
+    {
+        _filter.realization() = local;
+    }
+
+    static sample_type step(local_type& local, const sample_type& in)
+    {
+        return local.process_one_sample(in);
+    }
+
+private:
+    Tfilter _filter;
+};
+
+/**
+ *  Series and parallel nodes. stage<I>() gives access to the leaves, e.g.
+ *  to check which stages were fused.
+ */
+template <typename Tsample, bool Parallel, typename ...Stages>
+class filter_graph_branch : public filter_graph_node<filter_graph_branch<Tsample, Parallel, Stages...>, Tsample>
+{
+    static_assert(sizeof...(Stages) >= 2u);
+
+public:
+    using sample_type = Tsample;
+    using value_type = typename std::tuple_element_t<0u, std::tuple<Stages...>>::value_type;
+    using local_type = std::tuple<typename Stages::local_type...>;
+
+    static constexpr auto order = (0u + ... + Stages::order);
+    static constexpr auto stage_count = sizeof...(Stages);
+
+    template <typename Tag>
+    static constexpr bool has_variable = (false || ... || Stages::template has_variable<Tag>);
+
+    constexpr explicit filter_graph_branch(const Stages& ...stages)
+    :   _stages{stages...}
+    {}
+
+    template <typename SearchTag>
+    constexpr void set_variable(const variable<SearchTag>& var, const value_type& value)
+    {
+        static_assert(has_variable<SearchTag>);
+        std::apply([&](auto& ...stage) { (..., this->set_node_variable(stage, var, value)); }, _stages);
+    }
+
+    template <std::size_t Index>
+    constexpr const auto& stage() const noexcept
+    {
+        return std::get<Index>(_stages);
+    }
+
+    constexpr void reset()
+    {
+        std::apply([](auto& ...stage) { (..., stage.reset()); }, _stages);
+    }
+
+    local_type load()
+    {
+        return std::apply([](auto& ...stage) { return local_type{stage.load()...}; }, _stages);
+    }
+
+    void store(const local_type& local)
+    {
+        store_impl(std::index_sequence_for<Stages...>{}, local);
+    }
+
+    static Tsample step(local_type& local, const Tsample& in)
+    {
+        return step_impl(std::index_sequence_for<Stages...>{}, local, in);
+    }
+
+private:
+    template <std::size_t ...Indexes>
+    void store_impl(const std::index_sequence<Indexes...>&, const local_type& local)
+    {
+        (..., std::get<Indexes>(_stages).store(std::get<Indexes>(local)));
+    }
+
+    template <std::size_t ...Indexes>
+    static Tsample step_impl(const std::index_sequence<Indexes...>&, local_type& local, Tsample in)
+    {
+        if constexpr (Parallel) {
+            return (... + Stages::step(std::get<Indexes>(local), in));
+        }
+        else {
+            (..., (in = Stages::step(std::get<Indexes>(local), in)));
+            return in;
+        }
+    }
+
+    std::tuple<Stages...> _stages;
+};
+
+template <typename Tsample, typename ...Stages>
+using series_filter = filter_graph_branch<Tsample, false, Stages...>;
+
+template <typename Tsample, typename ...Stages>
+using parallel_filter = filter_graph_branch<Tsample, true, Stages...>;
+
+template <typename Tsample, typename Realization>
+struct filter_graph_builder
+{
+    template <typename E, unsigned int Order, typename ...Tags, typename ...Ts>
+    static constexpr auto build(const fused_stage<E, Order>& stage, const variable_binding<Tags, Ts>& ...bindings)
+    {
+        const auto z_transfert_function =
+            bind_variables(bilinear_transform(stage.laplace_transfert_function), bindings...);
+        using z_transform_type = std::decay_t<decltype(z_transfert_function)>;
+        using filter_type = iir_filter_implementation<Tsample, z_transform_type, Realization, no_instrumentation>;
+        return filter_graph_leaf<filter_type>{filter_type{z_transfert_function}};
+    }
+
+    template <typename ...P, typename ...Tags, typename ...Ts>
+    static constexpr auto build(const series_plan<P...>& plan, const variable_binding<Tags, Ts>& ...bindings)
+    {
+        return std::apply(
+            [&bindings...](const auto& ...stages)
+            {
+                return series_filter<Tsample, decltype(build(stages, bindings...))...>{build(stages, bindings...)...};
+            },
+            plan.stages);
+    }
+
+    template <typename ...P, typename ...Tags, typename ...Ts>
+    static constexpr auto build(const parallel_plan<P...>& plan, const variable_binding<Tags, Ts>& ...bindings)
+    {
+        return std::apply(
+            [&bindings...](const auto& ...stages)
+            {
+                return parallel_filter<Tsample, decltype(build(stages, bindings...))...>{build(stages, bindings...)...};
+            },
+            plan.stages);
+    }
+};
+
+/**
+ *  Build a filter graph, with the same variable bindings as make_filter
+ *  (a binding applies to every stage using the variable).
+ */
+template <
+    typename Tsample, typename Realization = transposed_direct_form_2, typename Policy = default_fusion_policy,
+    typename G, typename ...Tags, typename ...Ts>
+constexpr auto make_filter_graph(const G& graph, const variable_binding<Tags, Ts>& ...bindings)
+{
+    return filter_graph_builder<Tsample, Realization>::build(filter_graph_planner<Policy>::plan(graph), bindings...);
+}
+
+#endif /* FILTER_GRAPH_H_ */
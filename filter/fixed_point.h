@@ -0,0 +1,240 @@
+#ifndef FIXED_POINT_H_
+#define FIXED_POINT_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "filter_design.h"
+
+/**
+ *  Fixed point realization, for signed integer samples (int16_t, int32_t) :
+ *
+ *      - coefficients are evaluated in double and quantized on update to
+ *        int32_t with FractionalBits fractional bits (Q(31 - F).F, F = 24
+ *        gives coefficients in [-128, 128[ with a 6e-8 step)
+ *      - Direct Form I with a single accumulator per output, wide enough
+ *        for the worst case sum (see accumulator_type)
+ *      - outputs are rounded to nearest and saturated to the Tsample range
+ *      - with ErrorFeedback (the default), the rounding error of each
+ *        output is added to the next accumulator instead (first order noise
+ *        shaping), which removes the limit cycles and DC offset of plain
+ *        rounding for low cutoff frequencies
+ *
+ *  The 2 Order + 1 products of a quantized coefficient (31 bits) and a
+ *  sample (sample bits - 1), plus the rounding terms, need
+ *
+ *      31 + (sample bits - 1) + ceil(log2(2 Order + 2)) + 1 bits
+ *
+ *  i.e. at most 54 bits for int16_t samples up to order 63, held by an
+ *  int64_t. int32_t samples need more than 64 bits : the accumulator is
+ *  then a 128 bits integer, where the compiler provides one (GCC, Clang),
+ *  and int32_t samples are rejected otherwise. The numerator loop of
+ *  process_block is not vectorized with 128 bits accumulators.
+ *
+ *  process_block computes the numerator of a tile of samples at once, as
+ *  an integer loop over the samples which the compiler vectorizes. Only
+ *  the feedback part then runs sample by sample.
+ */
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef __int128 fixed_point_wide_accumulator;
+#endif
+
+//  Bits of the sum of the 2 Order + 1 products and of the rounding terms, sign included
+template <typename Tsample, unsigned int Order>
+constexpr unsigned int fixed_point_accumulator_bits()
+{
+    unsigned int log2_terms = 0u;
+    while ((1u << log2_terms) < 2u * Order + 2u)
+        ++log2_terms;
+    return 31u + (8u * sizeof(Tsample) - 1u) + log2_terms + 1u;
+}
+
+template <typename Tsample, unsigned int Order, bool Narrow = (fixed_point_accumulator_bits<Tsample, Order>() <= 64u)>
+struct fixed_point_accumulator
+{
+    using type = std::int64_t;
+};
+
+template <typename Tsample, unsigned int Order>
+struct fixed_point_accumulator<Tsample, Order, false>
+{
+#if defined(__SIZEOF_INT128__)
+    using type = fixed_point_wide_accumulator;
+#else
+    static_assert(sizeof(Tsample) == 0u, "no integer type wide enough for the fixed point accumulator of these samples");
+#endif
+};
+
+template <typename Tsample, unsigned int Order>
+using fixed_point_accumulator_t = typename fixed_point_accumulator<Tsample, Order>::type;
+
+/*
+ *  ErrorFeedback = false is plain rounding : for an int16_t second order
+ *  lowpass at 50 Hz / 48 kHz, the outputs are then up to about 5000 LSB off
+ *  a double reference, 33 LSB with error feedback, for the same speed.
+ */
+template <unsigned int FractionalBits = 24u, bool ErrorFeedback = true>
+struct fixed_point
+{
+    static_assert(FractionalBits >= 1u && FractionalBits <= 30u);
+
+    template <typename Tsample, unsigned int Order>
+    class implementation
+    {
+        static_assert(std::is_integral_v<Tsample> && std::is_signed_v<Tsample> && sizeof(Tsample) <= 4u);
+
+    public:
+        using value_type = double;
+        using coefficients_type = filter_coefficients<value_type, Order>;
+        using quantized_type = std::int32_t;
+        using accumulator_type = fixed_point_accumulator_t<Tsample, Order>;
+
+        static constexpr auto fractional_bits = FractionalBits;
+
+        void set_coefficients(const coefficients_type& coefficients)
+        {
+            for (auto k = 0u; k <= Order; ++k)
+                _feedforward[k] = quantize(coefficients.feedforward[k]);
+            for (auto k = 0u; k < Order; ++k)
+                _feedback[k] = quantize(coefficients.feedback[k]);
+        }
+
+        Tsample process_one_sample(const Tsample& in)
+        {
+            accumulator_type accumulator = static_cast<accumulator_type>(_feedforward[0]) * in;
+            for (auto k = 0u; k < Order; ++k)
+                accumulator += static_cast<accumulator_type>(_feedforward[k + 1u]) * _input_history[k];
+
+            push(_input_history, in);
+            return feedback_step(_feedback, _output_history, _error, accumulator);
+        }
+
+        /**
+         *  Tiles of inputs are copied after the Order previous inputs, so that
+         *  the numerator of every sample of the tile is read from one buffer.
+         */
+        void process_block(const Tsample* in, Tsample* out, std::size_t count)
+        {
+            const feedforward_type feedforward = _feedforward;
+            const feedback_type feedback = _feedback;
+            output_history_type output_history = _output_history;
+            accumulator_type error = _error;
+
+            //  window[Order + i] = x[i], window[Order - k] = x[-k]
+            Tsample window[Order + tile_size];
+            for (auto k = 0u; k < Order; ++k)
+                window[Order - 1u - k] = _input_history[k];
+
+            for (std::size_t begin = 0u; begin < count; begin += tile_size) {
+                const auto size = std::min(tile_size, count - begin);
+                std::copy_n(in + begin, size, window + Order);
+
+                accumulator_type accumulators[tile_size];
+                for (std::size_t i = 0u; i < size; ++i)
+                    accumulators[i] = static_cast<accumulator_type>(feedforward[0]) * window[Order + i];
+                for (auto k = 1u; k <= Order; ++k)
+                    for (std::size_t i = 0u; i < size; ++i)
+                        accumulators[i] += static_cast<accumulator_type>(feedforward[k]) * window[Order + i - k];
+
+                for (std::size_t i = 0u; i < size; ++i)
+                    out[begin + i] = feedback_step(feedback, output_history, error, accumulators[i]);
+
+                //  Last inputs of the tile : history of the next one
+                std::copy_n(window + size, Order, window);
+            }
+
+            for (auto k = 0u; k < Order; ++k)
+                _input_history[k] = window[Order - 1u - k];
+            _output_history = output_history;
+            _error = error;
+        }
+
+        constexpr void reset()
+        {
+            _input_history = input_history_type{};
+            _output_history = output_history_type{};
+            _error = 0;
+        }
+
+    private:
+        static constexpr std::size_t tile_size = 64u;
+        static constexpr accumulator_type one = accumulator_type{1} << FractionalBits;
+
+        using feedforward_type = std::array<quantized_type, Order + 1u>;
+        using feedback_type = std::array<quantized_type, Order>;
+
+        //  x[n - 1], ..., x[n - Order] and y[n - 1], ..., y[n - Order]
+        using history_type = std::array<Tsample, Order>;
+        using input_history_type = history_type;
+        using output_history_type = history_type;
+
+        static quantized_type quantize(const value_type& coefficient)
+        {
+            constexpr auto min = static_cast<value_type>(std::numeric_limits<quantized_type>::min());
+            constexpr auto max = static_cast<value_type>(std::numeric_limits<quantized_type>::max());
+            return static_cast<quantized_type>(std::clamp(std::round(coefficient * static_cast<value_type>(one)), min, max));
+        }
+
+        static Tsample saturate(const accumulator_type& value)
+        {
+            constexpr auto min = static_cast<accumulator_type>(std::numeric_limits<Tsample>::min());
+            constexpr auto max = static_cast<accumulator_type>(std::numeric_limits<Tsample>::max());
+            return static_cast<Tsample>(std::clamp(value, min, max));
+        }
+
+        //  Subtract the feedback from the numerator accumulator, and scale back to Tsample
+        static Tsample feedback_step(
+            const feedback_type& feedback, output_history_type& output_history,
+            accumulator_type& error, accumulator_type accumulator)
+        {
+            accumulator = subtract_feedback(
+                std::make_integer_sequence<unsigned int, Order>{}, feedback, output_history, accumulator);
+
+            accumulator_type scaled;
+            if constexpr (ErrorFeedback) {
+                accumulator += error;
+                scaled = accumulator >> FractionalBits;
+                error = accumulator - (scaled << FractionalBits);
+            }
+            else {
+                scaled = (accumulator + (one >> 1)) >> FractionalBits;
+            }
+
+            const Tsample out = saturate(scaled);
+            push(output_history, out);
+            return out;
+        }
+
+        //  Oldest first : only the last product depends on the previous output
+        template <unsigned int ...Indexes>
+        static accumulator_type subtract_feedback(
+            const std::integer_sequence<unsigned int, Indexes...>&,
+            const feedback_type& feedback, const output_history_type& output_history,
+            const accumulator_type& accumulator)
+        {
+            return (accumulator - ... -
+                (static_cast<accumulator_type>(feedback[Order - 1u - Indexes]) * output_history[Order - 1u - Indexes]));
+        }
+
+        static void push(history_type& history, const Tsample& value)
+        {
+            for (auto k = Order - 1u; k > 0u; --k)
+                history[k] = history[k - 1u];
+            history[0] = value;
+        }
+
+        feedforward_type _feedforward{};
+        feedback_type _feedback{};
+        input_history_type _input_history{};
+        output_history_type _output_history{};
+        accumulator_type _error{0};
+    };
+};
+
+#endif /* FIXED_POINT_H_ */
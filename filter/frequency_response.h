@@ -0,0 +1,109 @@
+#ifndef FREQUENCY_RESPONSE_H_
+#define FREQUENCY_RESPONSE_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+#include "filter_design.h"
+
+/**
+ *  Frequency response of normalized coefficients, at count angular
+ *  frequencies w in radians per sample (w = 2 pi f T) :
+ *
+ *      H(w) = B(u) / A(u),     u = e^(-jw)
+ *
+ *  B and A are evaluated with Horner's scheme over tiles of frequencies,
+ *  each step being a loop over the tile on separate real and imaginary
+ *  arrays, which the compiler vectorizes. The group delay, in samples,
+ *  uses the polynomials weighted by their degree :
+ *
+ *      delay(w) = Re(B'(u) / B(u)) - Re(A'(u) / A(u)),    P'(u) = sum k p(k) u^k
+ *
+ *  It is not defined where B(u) = 0. Any of magnitude, phase (radians, in
+ *  [-pi, pi]) and group_delay can be null when not needed.
+ */
+template <typename T, unsigned int Order>
+void frequency_response(
+    const filter_coefficients<T, Order>& coefficients,
+    const T* frequencies, std::size_t count,
+    T* magnitude, T* phase = nullptr, T* group_delay = nullptr)
+{
+    constexpr std::size_t tile_size = 64u;
+    using polynomial_type = std::array<T, Order + 1u>;
+
+    //  Horner : value = sum p(k) u^k, for each frequency of the tile
+    const auto horner =
+        [](const polynomial_type& polynomial,
+            const T* cosines, const T* sines, std::size_t size, T* real, T* imag)
+        {
+            std::fill_n(real, size, polynomial[Order]);
+            std::fill_n(imag, size, T{0});
+
+            for (auto k = Order; k > 0u; --k) {
+                const T coefficient = polynomial[k - 1u];
+                for (std::size_t i = 0u; i < size; ++i) {
+                    //  (re + j im) (cos - j sin) + p(k - 1)
+                    const T re = real[i] * cosines[i] + imag[i] * sines[i] + coefficient;
+                    const T im = imag[i] * cosines[i] - real[i] * sines[i];
+                    real[i] = re;
+                    imag[i] = im;
+                }
+            }
+        };
+
+    polynomial_type numerator = coefficients.feedforward;
+    polynomial_type denominator{};
+    denominator[0] = T{1};
+    std::copy(coefficients.feedback.begin(), coefficients.feedback.end(), denominator.begin() + 1);
+
+    polynomial_type weighted_numerator{};
+    polynomial_type weighted_denominator{};
+    for (auto k = 0u; k <= Order; ++k) {
+        weighted_numerator[k] = static_cast<T>(k) * numerator[k];
+        weighted_denominator[k] = static_cast<T>(k) * denominator[k];
+    }
+
+    for (std::size_t begin = 0u; begin < count; begin += tile_size) {
+        const auto size = std::min(tile_size, count - begin);
+
+        T cosines[tile_size], sines[tile_size];
+        for (std::size_t i = 0u; i < size; ++i) {
+            cosines[i] = std::cos(frequencies[begin + i]);
+            sines[i] = std::sin(frequencies[begin + i]);
+        }
+
+        T num_re[tile_size], num_im[tile_size], den_re[tile_size], den_im[tile_size];
+        horner(numerator, cosines, sines, size, num_re, num_im);
+        horner(denominator, cosines, sines, size, den_re, den_im);
+
+        for (std::size_t i = 0u; i < size; ++i) {
+            const T num_norm = num_re[i] * num_re[i] + num_im[i] * num_im[i];
+            const T den_norm = den_re[i] * den_re[i] + den_im[i] * den_im[i];
+
+            if (magnitude != nullptr)
+                magnitude[begin + i] = std::sqrt(num_norm / den_norm);
+
+            //  arg(B / A) = arg(B conj(A))
+            if (phase != nullptr)
+                phase[begin + i] = std::atan2(
+                    num_im[i] * den_re[i] - num_re[i] * den_im[i],
+                    num_re[i] * den_re[i] + num_im[i] * den_im[i]);
+        }
+
+        if (group_delay != nullptr) {
+            T wnum_re[tile_size], wnum_im[tile_size], wden_re[tile_size], wden_im[tile_size];
+            horner(weighted_numerator, cosines, sines, size, wnum_re, wnum_im);
+            horner(weighted_denominator, cosines, sines, size, wden_re, wden_im);
+
+            //  Re(X / Y) = (Xr Yr + Xi Yi) / |Y|^2
+            for (std::size_t i = 0u; i < size; ++i)
+                group_delay[begin + i] =
+                    (wnum_re[i] * num_re[i] + wnum_im[i] * num_im[i]) / (num_re[i] * num_re[i] + num_im[i] * num_im[i]) -
+                    (wden_re[i] * den_re[i] + wden_im[i] * den_im[i]) / (den_re[i] * den_re[i] + den_im[i] * den_im[i]);
+        }
+    }
+}
+
+#endif /* FREQUENCY_RESPONSE_H_ */
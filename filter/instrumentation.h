@@ -0,0 +1,186 @@
+#ifndef INSTRUMENTATION_H_
+#define INSTRUMENTATION_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+/**
+ *  Instrumentation policies for iir_filter_implementation. The filter only
+ *  calls the policy under if constexpr (Instrumentation::enabled) : with
+ *  no_instrumentation (the default) nothing is measured nor compiled in.
+ */
+struct no_instrumentation
+{
+    static constexpr bool enabled = false;
+};
+
+/**
+ *  Counters of one filter instance, as read by a snapshot. Block latencies
+ *  are in nanoseconds, bucket i of the histogram counting the blocks that
+ *  took [2^i, 2^(i + 1)[ ns (bucket 0 includes 0 ns).
+ */
+struct instrumentation_snapshot
+{
+    static constexpr std::size_t histogram_size = 32u;
+
+    std::uint64_t samples{0u};
+    std::uint64_t blocks{0u};
+    std::uint64_t block_nanoseconds{0u};
+    std::uint64_t variable_changes{0u};
+    std::uint64_t coefficient_updates{0u};
+    std::uint64_t coefficient_update_nanoseconds{0u};
+    std::uint64_t subnormal_outputs{0u};
+    std::array<std::uint64_t, histogram_size> block_latency_histogram{};
+};
+
+/**
+ *  Per instance counters. The filter is the only writer : counters are
+ *  relaxed atomics updated without read-modify-write instructions, so that
+ *  snapshot() can be called from another thread (e.g. a metrics scraper)
+ *  without slowing down the processing thread.
+ *
+ *  Only process_block and process_offline are timed, process_one_sample is
+ *  counted. A copy of a filter starts with its own, null, counters.
+ */
+class filter_instrumentation
+{
+
+public:
+    static constexpr bool enabled = true;
+
+    using clock = std::chrono::steady_clock;
+
+    filter_instrumentation() = default;
+
+    filter_instrumentation(const filter_instrumentation&) noexcept
+    {}
+
+    filter_instrumentation& operator=(const filter_instrumentation&) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    instrumentation_snapshot snapshot() const noexcept
+    {
+        instrumentation_snapshot result{};
+
+        result.samples = load(_samples);
+        result.blocks = load(_blocks);
+        result.block_nanoseconds = load(_block_nanoseconds);
+        result.variable_changes = load(_variable_changes);
+        result.coefficient_updates = load(_coefficient_updates);
+        result.coefficient_update_nanoseconds = load(_coefficient_update_nanoseconds);
+        result.subnormal_outputs = load(_subnormal_outputs);
+        for (auto i = 0u; i < histogram_size; ++i)
+            result.block_latency_histogram[i] = load(_block_latency_histogram[i]);
+
+        return result;
+    }
+
+    //  Not to be called concurrently with processing
+    void reset() noexcept
+    {
+        for (auto* counter : {
+                &_samples, &_blocks, &_block_nanoseconds, &_variable_changes,
+                &_coefficient_updates, &_coefficient_update_nanoseconds, &_subnormal_outputs})
+            counter->store(0u, std::memory_order_relaxed);
+        for (auto& counter : _block_latency_histogram)
+            counter.store(0u, std::memory_order_relaxed);
+    }
+
+    //  Hooks called by the filter
+
+    template <typename Tsample>
+    void record_sample(const Tsample& out) noexcept
+    {
+        add(_samples, 1u);
+        if (is_subnormal(out))
+            add(_subnormal_outputs, 1u);
+    }
+
+    template <typename Tsample>
+    void record_block(clock::duration duration, const Tsample* out, std::size_t count) noexcept
+    {
+        const auto nanoseconds = to_nanoseconds(duration);
+
+        add(_samples, count);
+        add(_blocks, 1u);
+        add(_block_nanoseconds, nanoseconds);
+        add(_block_latency_histogram[histogram_bucket(nanoseconds)], 1u);
+
+        std::uint64_t subnormals = 0u;
+        for (std::size_t i = 0u; i < count; ++i)
+            subnormals += is_subnormal(out[i]) ? 1u : 0u;
+        if (subnormals != 0u)
+            add(_subnormal_outputs, subnormals);
+    }
+
+    void record_variable_change() noexcept
+    {
+        add(_variable_changes, 1u);
+    }
+
+    void record_coefficient_update(clock::duration duration) noexcept
+    {
+        add(_coefficient_updates, 1u);
+        add(_coefficient_update_nanoseconds, to_nanoseconds(duration));
+    }
+
+private:
+    static constexpr auto histogram_size = instrumentation_snapshot::histogram_size;
+
+    using counter_type = std::atomic<std::uint64_t>;
+
+    static std::uint64_t load(const counter_type& counter) noexcept
+    {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+    //  Single writer : a plain load and store is enough
+    static void add(counter_type& counter, std::uint64_t value) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static std::uint64_t to_nanoseconds(clock::duration duration) noexcept
+    {
+        const auto count = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        return (count > 0) ? static_cast<std::uint64_t>(count) : 0u;
+    }
+
+    //  floor(log2(nanoseconds)), clamped to the histogram
+    static std::size_t histogram_bucket(std::uint64_t nanoseconds) noexcept
+    {
+        std::size_t bucket = 0u;
+        while ((nanoseconds >>= 1u) != 0u && bucket + 1u < histogram_size)
+            ++bucket;
+        return bucket;
+    }
+
+    template <typename Tsample>
+    static bool is_subnormal(const Tsample& value) noexcept
+    {
+        if constexpr (std::is_floating_point_v<Tsample>)
+            return value != Tsample{0} && std::abs(value) < std::numeric_limits<Tsample>::min();
+        else
+            return false;
+    }
+
+    counter_type _samples{0u};
+    counter_type _blocks{0u};
+    counter_type _block_nanoseconds{0u};
+    counter_type _variable_changes{0u};
+    counter_type _coefficient_updates{0u};
+    counter_type _coefficient_update_nanoseconds{0u};
+    counter_type _subnormal_outputs{0u};
+    std::array<counter_type, histogram_size> _block_latency_histogram{};
+};
+
+#endif /* INSTRUMENTATION_H_ */
@@ -0,0 +1,317 @@
+#ifndef MULTIRATE_H_
+#define MULTIRATE_H_
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "../bilinear_transform/bilinear_transform.h"
+#include "filter_design.h"
+
+/**
+ *  Multirate filters : filtering fused with a rate change by Factor, in
+ *  one pass over the samples.
+ *
+ *  The feedback part of an IIR filter needs every sample at the high rate,
+ *  but the feedforward part can be skipped where its result is not needed
+ *  (decimation) or where its input is zero (interpolation) :
+ *
+ *      decimating_filter    : Direct Form II. The feedback recursion runs on
+ *                             every input, the numerator only for the kept
+ *                             outputs : Order + 1 multiply-adds per output
+ *                             instead of per input.
+ *
+ *      interpolating_filter : Direct Form I on the zero-stuffed input. Output
+ *                             phase p only sees the numerator taps p, p + Factor,
+ *                             ... : about (Order + 1) / Factor multiply-adds
+ *                             per output instead of Order + 1.
+ *
+ *  Zero stuffing divides the passband gain by Factor : an interpolation
+ *  filter usually has Factor in its numerator.
+ */
+
+//-
+
+template <typename Tsample, unsigned int Factor, typename Tztransform>
+class decimating_filter;
+
+template <typename Tsample, unsigned int Factor, typename Pnumerator, typename Pdenominator>
+class decimating_filter<Tsample, Factor, rational_fraction<Pnumerator, Pdenominator>>
+{
+    static_assert(Factor >= 1u);
+
+public:
+    using Tztransform = rational_fraction<Pnumerator, Pdenominator>;
+    using design_type = filter_design<Tsample, Tztransform>;
+    using info = typename design_type::info;
+    using coefficients_type = typename design_type::coefficients_type;
+    using sample_type = Tsample;
+
+    static constexpr auto factor = Factor;
+
+    constexpr decimating_filter(const Tztransform& transfert_function)
+    :   _design{transfert_function}
+    {}
+
+    /**
+     *  Filter count input samples and keep one output every Factor inputs.
+     *  The position in the current group of Factor inputs is kept between
+     *  calls, so count needs not be a multiple of Factor. Returns the number
+     *  of outputs written to out. in and out may be the same buffer.
+     */
+    std::size_t process_block(const Tsample* in, Tsample* out, std::size_t count)
+    {
+        const coefficients_type coefficients = _design.coefficients();
+        history_type history = _history;
+        std::size_t phase = _phase;
+        std::size_t i = 0u;
+        std::size_t written = 0u;
+
+        //  Complete the pending group, then whole groups, then start the next one
+        for (; phase != 0u && i < count; ++i) {
+            if (phase == Factor - 1u) {
+                out[written++] = output_step(coefficients, history, in[i]);
+                phase = 0u;
+            }
+            else {
+                feedback_step(coefficients, history, in[i]);
+                ++phase;
+            }
+        }
+
+        for (; i + Factor <= count; i += Factor) {
+            for (auto k = 0u; k + 1u < Factor; ++k)
+                feedback_step(coefficients, history, in[i + k]);
+            out[written++] = output_step(coefficients, history, in[i + Factor - 1u]);
+        }
+
+        for (; i < count; ++i)
+            feedback_step(coefficients, history, in[i]);
+
+        _history = history;
+        _phase = (_phase + count) % Factor;
+        return written;
+    }
+
+    template <typename SearchTag>
+    constexpr void set_variable(const variable<SearchTag>& var, const Tsample& value)
+    {
+        _design.set_variable(var, value);
+    }
+
+    constexpr const design_type& design() const noexcept
+    {
+        return _design;
+    }
+
+    constexpr void reset()
+    {
+        _history = history_type{};
+        _phase = 0u;
+    }
+
+private:
+    static constexpr auto order = info::filter_order;
+
+    //  w[n - 1], ..., w[n - Order]
+    using history_type = std::array<Tsample, order>;
+
+    //  w[n] = x[n] - sum a(k) w[n - k]
+    static void feedback_step(const coefficients_type& coefficients, history_type& history, const Tsample& in)
+    {
+        push(history, subtract_feedback(std::make_integer_sequence<unsigned int, order>{}, coefficients, history, in));
+    }
+
+    //  The same, and y[n] = sum b(k) w[n - k]
+    static Tsample output_step(const coefficients_type& coefficients, history_type& history, const Tsample& in)
+    {
+        const Tsample w = subtract_feedback(std::make_integer_sequence<unsigned int, order>{}, coefficients, history, in);
+        const Tsample out =
+            coefficients.feedforward[0] * w +
+            feedforward_sum(std::make_integer_sequence<unsigned int, order>{}, coefficients, history);
+
+        push(history, w);
+        return out;
+    }
+
+    static void push(history_type& history, const Tsample& w)
+    {
+        for (auto k = order - 1u; k > 0u; --k)
+            history[k] = history[k - 1u];
+        history[0] = w;
+    }
+
+    //  value - sum a(k) w[n - k], oldest first : only the last product depends on the previous step
+    template <unsigned int ...Indexes>
+    static Tsample subtract_feedback(
+        const std::integer_sequence<unsigned int, Indexes...>&,
+        const coefficients_type& coefficients, const history_type& history, const Tsample& value)
+    {
+        return (value - ... - (coefficients.feedback[order - 1u - Indexes] * history[order - 1u - Indexes]));
+    }
+
+    template <unsigned int ...Indexes>
+    static Tsample feedforward_sum(
+        const std::integer_sequence<unsigned int, Indexes...>&,
+        const coefficients_type& coefficients, const history_type& history)
+    {
+        return (... + (coefficients.feedforward[Indexes + 1u] * history[Indexes]));
+    }
+
+    design_type _design;
+    history_type _history{};
+    std::size_t _phase{0u};
+};
+
+//-
+
+template <typename Tsample, unsigned int Factor, typename Tztransform>
+class interpolating_filter;
+
+template <typename Tsample, unsigned int Factor, typename Pnumerator, typename Pdenominator>
+class interpolating_filter<Tsample, Factor, rational_fraction<Pnumerator, Pdenominator>>
+{
+    static_assert(Factor >= 1u);
+
+public:
+    using Tztransform = rational_fraction<Pnumerator, Pdenominator>;
+    using design_type = filter_design<Tsample, Tztransform>;
+    using info = typename design_type::info;
+    using coefficients_type = typename design_type::coefficients_type;
+    using sample_type = Tsample;
+
+    static constexpr auto factor = Factor;
+
+    constexpr interpolating_filter(const Tztransform& transfert_function)
+    :   _design{transfert_function}
+    {}
+
+    /**
+     *  Filter count input samples, each one followed by Factor - 1 zeros :
+     *  count * Factor outputs are written to out.
+     */
+    void process_block(const Tsample* in, Tsample* out, std::size_t count)
+    {
+        const coefficients_type coefficients = _design.coefficients();
+        input_history_type input_history = _input_history;
+        output_history_type output_history = _output_history;
+
+        for (std::size_t i = 0u; i < count; ++i) {
+            for (auto j = taps_per_phase - 1u; j > 0u; --j)
+                input_history[j] = input_history[j - 1u];
+            input_history[0] = in[i];
+
+            phases_step(
+                std::make_integer_sequence<unsigned int, Factor>{},
+                coefficients, input_history, output_history, out + i * Factor);
+        }
+
+        _input_history = input_history;
+        _output_history = output_history;
+    }
+
+    template <typename SearchTag>
+    constexpr void set_variable(const variable<SearchTag>& var, const Tsample& value)
+    {
+        _design.set_variable(var, value);
+    }
+
+    constexpr const design_type& design() const noexcept
+    {
+        return _design;
+    }
+
+    constexpr void reset()
+    {
+        _input_history = input_history_type{};
+        _output_history = output_history_type{};
+    }
+
+private:
+    static constexpr auto order = info::filter_order;
+
+    //  Numerator taps seen by the first phase : 0, Factor, 2 * Factor, ...
+    static constexpr auto taps_per_phase = order / Factor + 1u;
+
+    //  Inputs before zero stuffing x[m], x[m - 1], ..., and outputs y[n - 1], ..., y[n - Order]
+    using input_history_type = std::array<Tsample, taps_per_phase>;
+    using output_history_type = std::array<Tsample, order>;
+
+    //  Numerator taps seen by a phase (none if Phase > Order)
+    static constexpr unsigned int phase_tap_count(unsigned int phase)
+    {
+        return (phase <= order) ? (order - phase) / Factor + 1u : 0u;
+    }
+
+    template <unsigned int ...Phases>
+    static void phases_step(
+        const std::integer_sequence<unsigned int, Phases...>&,
+        const coefficients_type& coefficients,
+        const input_history_type& input_history,
+        output_history_type& output_history,
+        Tsample* out)
+    {
+        (..., (out[Phases] = phase_step<Phases>(
+            std::make_integer_sequence<unsigned int, phase_tap_count(Phases)>{},
+            coefficients, input_history, output_history)));
+    }
+
+    //  y[mL + p] = sum(j) b(p + jL) x[m - j] - sum(k) a(k) y[mL + p - k]
+    template <unsigned int Phase, unsigned int ...Taps>
+    static Tsample phase_step(
+        const std::integer_sequence<unsigned int, Taps...>&,
+        const coefficients_type& coefficients,
+        const input_history_type& input_history,
+        output_history_type& output_history)
+    {
+        Tsample feedforward{0};
+        if constexpr (sizeof...(Taps) != 0u)
+            feedforward = (... + (coefficients.feedforward[Phase + Taps * Factor] * input_history[Taps]));
+
+        const Tsample out = subtract_feedback(
+            std::make_integer_sequence<unsigned int, order>{}, coefficients, output_history, feedforward);
+
+        for (auto k = order - 1u; k > 0u; --k)
+            output_history[k] = output_history[k - 1u];
+        output_history[0] = out;
+        return out;
+    }
+
+    //  value - sum a(k) y[n - k], oldest first : only the last product depends on the previous step
+    template <unsigned int ...Indexes>
+    static Tsample subtract_feedback(
+        const std::integer_sequence<unsigned int, Indexes...>&,
+        const coefficients_type& coefficients, const output_history_type& history, const Tsample& value)
+    {
+        return (value - ... - (coefficients.feedback[order - 1u - Indexes] * history[order - 1u - Indexes]));
+    }
+
+    design_type _design;
+    input_history_type _input_history{};
+    output_history_type _output_history{};
+};
+
+//-
+
+/**
+ *  Build multirate filters from a laplace transfert function, with the same
+ *  variable bindings as make_filter.
+ */
+template <typename Tsample, unsigned int Factor, typename E, typename ...Tags, typename ...Ts>
+constexpr auto make_decimating_filter(const expression<E>& laplace_transfert_function, const variable_binding<Tags, Ts>& ...bindings)
+{
+    const auto z_transfert_function = bind_variables(bilinear_transform(laplace_transfert_function), bindings...);
+    using z_transform_type = std::decay_t<decltype(z_transfert_function)>;
+    return decimating_filter<Tsample, Factor, z_transform_type>{z_transfert_function};
+}
+
+template <typename Tsample, unsigned int Factor, typename E, typename ...Tags, typename ...Ts>
+constexpr auto make_interpolating_filter(const expression<E>& laplace_transfert_function, const variable_binding<Tags, Ts>& ...bindings)
+{
+    const auto z_transfert_function = bind_variables(bilinear_transform(laplace_transfert_function), bindings...);
+    using z_transform_type = std::decay_t<decltype(z_transfert_function)>;
+    return interpolating_filter<Tsample, Factor, z_transform_type>{z_transfert_function};
+}
+
+#endif /* MULTIRATE_H_ */
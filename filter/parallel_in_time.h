@@ -0,0 +1,158 @@
+#ifndef PARALLEL_IN_TIME_H_
+#define PARALLEL_IN_TIME_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <thread>
+#include <vector>
+
+/**
+ *  Parallel in time processing of a long signal, for the Transposed
+ *  Direct Form II. The filter is linear : the output of a chunk is the
+ *  output obtained from a zero state, plus the zero-input response of the
+ *  state at the start of the chunk. The signal is split in chunks which are
+ *
+ *      1. filtered in parallel, the first one from the filter state and
+ *         the others from zero
+ *      2. scanned in order : the start state of a chunk is the zero-input
+ *         evolution of the previous start state, plus the zero-state end
+ *         state of the previous chunk
+ *      3. corrected in parallel by adding the zero-input responses
+ *
+ *  Zero-input responses stop once the state has decayed below rounding.
+ *  For a stable filter they are short compared to the chunks, so the work
+ *  is close to a serial pass split over the threads. The state is evolved
+ *  sample by sample rather than by powers of the transition matrix, which
+ *  are badly conditioned for low cutoff frequencies.
+ */
+template <typename Trealization>
+class parallel_in_time
+{
+
+public:
+    using value_type = typename Trealization::value_type;
+    using state_type = typename Trealization::state_type;
+    using coefficients_type = typename Trealization::coefficients_type;
+
+    static constexpr auto order = Trealization::order;
+
+    //  Below, chunks are too short for the threads to pay off
+    static constexpr std::size_t min_chunk_size = 1u << 14;
+
+    static void process(
+        Trealization& realization, const value_type* in, value_type* out,
+        std::size_t count, std::size_t thread_count)
+    {
+        const auto chunk_count = std::min(thread_count, count / min_chunk_size);
+
+        if (chunk_count <= 1u) {
+            realization.process_block(in, out, count);
+            return;
+        }
+
+        const auto chunk_begin = [count, chunk_count](std::size_t chunk) { return count * chunk / chunk_count; };
+        std::vector<state_type> end_states(chunk_count);
+
+        //  1. Chunks filtered independently
+        run_parallel(0u, chunk_count,
+            [&](std::size_t chunk)
+            {
+                Trealization chunk_realization = realization;
+                if (chunk != 0u)
+                    chunk_realization.reset();
+
+                const auto begin = chunk_begin(chunk);
+                chunk_realization.process_block(in + begin, out + begin, chunk_begin(chunk + 1u) - begin);
+                end_states[chunk] = chunk_realization.state();
+            });
+
+        //  2. Scan : start state of the next chunk = zero-input evolution + zero-state end state
+        const auto& coefficients = realization.coefficients();
+        std::vector<state_type> start_states(chunk_count + 1u);
+        start_states[1] = end_states[0];
+
+        for (std::size_t chunk = 1u; chunk < chunk_count; ++chunk) {
+            const auto length = chunk_begin(chunk + 1u) - chunk_begin(chunk);
+            const auto evolved = zero_input_response(coefficients, start_states[chunk], nullptr, length);
+            for (auto k = 0u; k < order; ++k)
+                start_states[chunk + 1u][k] = evolved[k] + end_states[chunk][k];
+        }
+
+        //  3. Zero-input responses
+        run_parallel(1u, chunk_count,
+            [&](std::size_t chunk)
+            {
+                const auto begin = chunk_begin(chunk);
+                zero_input_response(coefficients, start_states[chunk], out + begin, chunk_begin(chunk + 1u) - begin);
+            });
+
+        realization.set_state(start_states[chunk_count]);
+    }
+
+private:
+    //  f(i) for i in [first, last[, the last one on the calling thread
+    template <typename Function>
+    static void run_parallel(std::size_t first, std::size_t last, const Function& function)
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(last - first);
+
+        for (auto i = first; i + 1u < last; ++i)
+            threads.emplace_back(function, i);
+        function(last - 1u);
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    static value_type magnitude(const state_type& state)
+    {
+        value_type result{0};
+        for (const auto& value : state)
+            result = std::max(result, std::abs(value));
+        return result;
+    }
+
+    /*
+     *  Evolve state over count samples without input, adding its response to
+     *  out when not null. Once the state has decayed below the rounding error
+     *  of its initial value, it is considered null.
+     */
+    static state_type zero_input_response(
+        const coefficients_type& coefficients, state_type state, value_type* out, std::size_t count)
+    {
+        constexpr std::size_t check_interval = 64u;
+        const auto threshold = magnitude(state) * std::numeric_limits<value_type>::epsilon();
+
+        for (std::size_t begin = 0u; begin < count; begin += check_interval) {
+            if (!(magnitude(state) > threshold))
+                return state_type{};
+
+            const auto end = std::min(begin + check_interval, count);
+            for (auto i = begin; i < end; ++i) {
+                const value_type response = state[0];
+                if (out != nullptr)
+                    out[i] += response;
+
+                for (auto k = 0u; k + 1u < order; ++k)
+                    state[k] = state[k + 1u] - coefficients.feedback[k] * response;
+                state[order - 1u] = -coefficients.feedback[order - 1u] * response;
+            }
+        }
+
+        return state;
+    }
+};
+
+template <typename Trealization>
+void process_parallel_in_time(
+    Trealization& realization,
+    const typename Trealization::value_type* in, typename Trealization::value_type* out,
+    std::size_t count, std::size_t thread_count = std::thread::hardware_concurrency())
+{
+    parallel_in_time<Trealization>::process(realization, in, out, count, thread_count);
+}
+
+#endif /* PARALLEL_IN_TIME_H_ */
@@ -0,0 +1,103 @@
+#ifndef PARAMETER_CHANNEL_H_
+#define PARAMETER_CHANNEL_H_
+
+#include "../expression/expression.h"
+#include "../utils/triple_buffer.h"
+
+/**
+ *  Parameter channel : variable changes sent from a control thread (e.g.
+ *  a user interface) to the thread processing a filter, without locks.
+ *
+ *  The control thread sets variables on its own copy of the design, and
+ *  publishes them all at once into a triple_buffer. The processing thread
+ *  calls apply() at block boundaries, which costs a single atomic load
+ *  when nothing was published. A published update is never torn : the
+ *  filter sees all of its values, or none of them.
+ *
+ *  The coefficients are evaluated by publish(), on the control thread.
+ *  With the direct forms (and fixed_point, which quantizes them), apply()
+ *  then only copies them into the realization. second_order_sections and
+ *  state_space_block still factorize them in apply(), on the processing
+ *  thread, as their set_coefficients does : publish() only saves them the
+ *  evaluation of the design. publish(false) leaves the evaluation to the
+ *  processing thread, as set_variable would.
+ *
+ *  One control thread and one processing thread per channel.
+ */
+template <typename Tfilter>
+class parameter_channel
+{
+
+public:
+    using filter_type = Tfilter;
+    using value_type = typename Tfilter::value_type;
+    using design_type = typename Tfilter::design_type;
+    using coefficients_type = typename Tfilter::coefficients_type;
+    using variable_values_type = typename Tfilter::variable_values_type;
+
+    //  Starts from the current variable values of filter
+    explicit parameter_channel(const Tfilter& filter)
+    :   _design{filter.design()}
+    {}
+
+    //  Control thread
+
+    template <typename SearchTag>
+    void set_variable(const variable<SearchTag>& var, const value_type& value)
+    {
+        _design.set_variable(var, value);
+    }
+
+    template <typename SearchTag>
+    value_type get_variable(const variable<SearchTag>& var) const
+    {
+        return _design.get_variable(var);
+    }
+
+    void publish(bool compute_coefficients = true)
+    {
+        auto& update = _updates.write_buffer();
+        update.values = _design.variable_values();
+        update.has_coefficients = compute_coefficients;
+        if (compute_coefficients)
+            update.coefficients = _design.coefficients();
+        _updates.publish();
+    }
+
+    /**
+     *  Coefficients computed beforehand (e.g. from a coefficient_table) for
+     *  the current variables : they are used until a variable changes.
+     */
+    void publish(const coefficients_type& coefficients)
+    {
+        _design.restore(_design.variable_values(), coefficients);
+        publish(true);
+    }
+
+    //  Processing thread : true if an update was applied to filter (see above for its cost)
+    bool apply(Tfilter& filter) noexcept
+    {
+        if (!_updates.update())
+            return false;
+
+        const auto& update = _updates.read_buffer();
+        if (update.has_coefficients)
+            filter.restore(update.values, update.coefficients);
+        else
+            filter.set_variable_values(update.values);
+        return true;
+    }
+
+private:
+    struct parameter_update
+    {
+        variable_values_type values{};
+        coefficients_type coefficients{};
+        bool has_coefficients{false};
+    };
+
+    design_type _design;
+    triple_buffer<parameter_update> _updates{};
+};
+
+#endif /* PARAMETER_CHANNEL_H_ */
@@ -0,0 +1,90 @@
+#ifndef PARAMETER_SMOOTHER_H_
+#define PARAMETER_SMOOTHER_H_
+
+#include <algorithm>
+#include <cstddef>
+
+#include "../expression/expression.h"
+
+/**
+ *  Linear ramp of a variable toward a target value
+ */
+template <typename T>
+struct variable_ramp
+{
+    T value{};
+    T target{};
+    T increment{};
+    std::size_t remaining{0u};
+
+    constexpr bool active() const noexcept
+    {
+        return remaining != 0u;
+    }
+
+    constexpr void advance(std::size_t samples)
+    {
+        const auto steps = std::min(samples, remaining);
+        remaining -= steps;
+        value = (remaining == 0u) ? target : value + increment * static_cast<T>(steps);
+    }
+};
+
+template <typename Tag, typename T>
+struct variable_ramp_association {
+    variable_ramp<T> ramp{};
+};
+
+/**
+ *  Parameter smoother : one ramp per variable. The ramps are advanced by
+ *  sub-blocks, and the ramped values are written into a filter design,
+ *  which then re-evaluates its coefficients once per sub-block.
+ */
+template <typename T, typename ...Tag>
+class parameter_smoother : variable_ramp_association<Tag, T>...
+{
+
+public:
+    constexpr parameter_smoother() = default;
+
+    template <typename SearchTag>
+    constexpr void set_target(const T& current, const T& target, std::size_t length)
+    {
+        auto& ramp = variable_ramp_association<SearchTag, T>::ramp;
+        ramp.value = current;
+        ramp.target = target;
+        ramp.increment = (target - current) / static_cast<T>(length);
+        ramp.remaining = length;
+    }
+
+    template <typename SearchTag>
+    constexpr void stop()
+    {
+        variable_ramp_association<SearchTag, T>::ramp.remaining = 0u;
+    }
+
+    constexpr bool active() const noexcept
+    {
+        return (false || ... || variable_ramp_association<Tag, T>::ramp.active());
+    }
+
+    template <typename Tdesign>
+    constexpr void advance(Tdesign& design, [[maybe_unused]] std::size_t samples)
+    {
+        (..., advance_ramp<Tag>(design, samples));
+    }
+
+private:
+    template <typename SearchTag, typename Tdesign>
+    constexpr void advance_ramp(Tdesign& design, std::size_t samples)
+    {
+        auto& ramp = variable_ramp_association<SearchTag, T>::ramp;
+
+        if (ramp.active()) {
+            ramp.advance(samples);
+            design.set_variable(variable<SearchTag>{}, ramp.value);
+        }
+    }
+};
+
+#endif /* PARAMETER_SMOOTHER_H_ */
@@ -0,0 +1,202 @@
+#ifndef POLYNOMIAL_ROOTS_H_
+#define POLYNOMIAL_ROOTS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+
+/**
+ *  Taylor coefficients p(c), p'(c), p''(c) / 2!, ... up to order count - 1
+ */
+template <unsigned int MaxDegree, typename T>
+void polynomial_taylor(
+    const T* coefficients, unsigned int degree,
+    const std::complex<T>& c, std::complex<T>* taylor, unsigned int count)
+{
+    std::complex<T> work[MaxDegree + 1u];
+    for (auto i = 0u; i <= degree; ++i)
+        work[i] = coefficients[i];
+
+    //  Repeated synthetic division by (x - c)
+    for (auto k = 0u; k < count; ++k) {
+        for (auto i = 1u; i <= degree - k; ++i)
+            work[i] += work[i - 1] * c;
+        taylor[k] = work[degree - k];
+    }
+}
+
+template <typename T>
+std::complex<T> reciprocal(const std::complex<T>& z)
+{
+    return std::conj(z) / std::norm(z);
+}
+
+/**
+ *  Roots of p(x) = coefficients[0] x^degree + ... + coefficients[degree]
+ *  using the Aberth-Ehrlich iteration. coefficients[0] must not be zero.
+ *  With from_guesses, the iteration starts from the given roots (e.g. the
+ *  roots of a slightly different polynomial) instead of a circle.
+ */
+template <unsigned int MaxDegree, typename T>
+void polynomial_roots(const T* coefficients, unsigned int degree, std::complex<T>* roots, bool from_guesses = false)
+{
+    using complex = std::complex<T>;
+
+    constexpr auto max_iteration = 500u;
+    constexpr T pi = T{3.14159265358979323846264338327950288};
+    const T tolerance = T{4} * std::numeric_limits<T>::epsilon();
+    const T rounding_error = T(degree) * std::numeric_limits<T>::epsilon();
+
+    if (degree == 0u)
+        return;
+
+    for (auto k = 0u; from_guesses && k < degree; ++k)
+        from_guesses = std::isfinite(roots[k].real()) && std::isfinite(roots[k].imag());
+
+    if (from_guesses) {
+        //  The iteration needs distinct points : coincident guesses, left by a
+        //  multiple root, are moved apart.
+        const T separation = std::sqrt(std::numeric_limits<T>::epsilon());
+        for (auto k = 1u; k < degree; ++k) {
+            const T scale = separation * std::max(T{1}, std::abs(roots[k]));
+            for (auto j = 0u; j < k; ++j) {
+                if (std::norm(roots[k] - roots[j]) <= scale * scale)
+                    roots[k] += std::polar(scale, T{2} * pi * T(k) / T(degree) + T{0.4});
+            }
+        }
+    }
+    else {
+        //  Initial guesses on a circle whose radius bounds the root moduli
+        T radius{0};
+        for (auto i = 1u; i <= degree; ++i)
+            radius = std::max(radius, std::pow(std::abs(coefficients[i] / coefficients[0]), T{1} / T(i)));
+        radius = radius == T{0} ? T{1} : radius;
+
+        for (auto k = 0u; k < degree; ++k)
+            roots[k] = std::polar(radius, T{2} * pi * T(k) / T(degree) + T{0.4});
+    }
+
+    //  A root is final once p is below its rounding error there : a multiple root
+    //  would otherwise take all the iterations to converge.
+    bool settled[MaxDegree];
+    for (auto k = 0u; k < degree; ++k)
+        settled[k] = false;
+
+    for (auto iteration = 0u; iteration < max_iteration; ++iteration) {
+        bool converged = true;
+
+        for (auto k = 0u; k < degree; ++k) {
+            if (settled[k])
+                continue;
+
+            //  Horner evaluation of p, p' and of the rounding error bound of p
+            const T modulus = std::sqrt(std::norm(roots[k]));
+            complex p{coefficients[0]};
+            complex dp{0};
+            T error_bound = std::abs(coefficients[0]);
+            for (auto i = 1u; i <= degree; ++i) {
+                dp = dp * roots[k] + p;
+                p = p * roots[k] + coefficients[i];
+                error_bound = error_bound * modulus + std::abs(coefficients[i]);
+            }
+
+            const T max_error = rounding_error * error_bound;
+            if (std::norm(p) <= max_error * max_error) {
+                settled[k] = true;
+                continue;
+            }
+
+            //  Divisions are written as a * conj(b) / |b|^2 : complex division is
+            //  an out of line call doing overflow checks, far slower than the rest.
+            complex repulsion{0};
+            for (auto j = 0u; j < degree; ++j) {
+                if (j != k)
+                    repulsion += reciprocal(roots[k] - roots[j]);
+            }
+
+            const complex newton = dp == complex{0} ? complex{tolerance} : p * reciprocal(dp);
+            const complex correction = newton * reciprocal(T{1} - newton * repulsion);
+            roots[k] -= correction;
+
+            if (std::norm(correction) > tolerance * tolerance * std::max(T{1}, std::norm(roots[k])))
+                converged = false;
+        }
+
+        if (converged)
+            break;
+    }
+
+    //  The iteration only converges linearly toward a root of multiplicity m and leaves
+    //  a cluster of m roots around it. Such a root is a simple root of the (m - 1)th
+    //  derivative : it is refined with Newton from the cluster mean, and replaces the
+    //  cluster when p and its m - 1 first derivatives vanish there.
+    const T cluster_radius{1e-2};
+    const T multiplicity_tolerance{1e-10};
+
+    bool clustered[MaxDegree];
+    for (auto i = 0u; i < degree; ++i)
+        clustered[i] = false;
+
+    for (auto i = 0u; i < degree; ++i) {
+        if (clustered[i])
+            continue;
+
+        //  Roots transitively closer than cluster_radius
+        bool in_cluster[MaxDegree];
+        unsigned int members[MaxDegree];
+        auto multiplicity = 0u;
+        complex mean{0};
+
+        for (auto j = 0u; j < degree; ++j)
+            in_cluster[j] = false;
+
+        in_cluster[i] = true;
+        members[multiplicity++] = i;
+
+        for (auto m = 0u; m < multiplicity; ++m) {
+            const auto& root = roots[members[m]];
+            mean += root;
+
+            for (auto j = i + 1u; j < degree; ++j) {
+                if (!clustered[j] && !in_cluster[j] &&
+                    std::abs(roots[j] - root) <= cluster_radius * std::max(T{1}, std::abs(root))) {
+                    in_cluster[j] = true;
+                    members[multiplicity++] = j;
+                }
+            }
+        }
+
+        if (multiplicity < 2u)
+            continue;
+
+        mean /= T(multiplicity);
+
+        complex taylor[MaxDegree + 1u];
+        for (auto iteration = 0u; iteration < 16u; ++iteration) {
+            polynomial_taylor<MaxDegree>(coefficients, degree, mean, taylor, std::min(multiplicity + 1u, degree + 1u));
+            if (taylor[multiplicity] == complex{0})
+                break;
+            mean -= taylor[multiplicity - 1u] / (T(multiplicity) * taylor[multiplicity]);
+        }
+
+        T scale{0};
+        for (auto k = 0u; k <= degree; ++k)
+            scale += std::abs(coefficients[k]) * std::pow(std::max(T{1}, std::abs(mean)), T(degree - k));
+
+        polynomial_taylor<MaxDegree>(coefficients, degree, mean, taylor, multiplicity);
+
+        bool is_multiple = true;
+        for (auto k = 0u; k < multiplicity; ++k)
+            is_multiple = is_multiple && (std::abs(taylor[k]) <= multiplicity_tolerance * scale);
+
+        if (is_multiple) {
+            for (auto k = 0u; k < multiplicity; ++k) {
+                roots[members[k]] = mean;
+                clustered[members[k]] = true;
+            }
+        }
+    }
+}
+
+#endif /* POLYNOMIAL_ROOTS_H_ */
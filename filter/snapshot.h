@@ -0,0 +1,473 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SNAPSHOT_USE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../bilinear_transform/rational_fraction.h"
+#include "../expression/expression.h"
+#include "../utils/type_list.h"
+#include "filter_bank.h"
+
+/**
+ *  Snapshots : the variables, normalized coefficients and optionally the
+ *  realization state of the filters of a bank, saved to a binary file. A
+ *  bank is restored from a snapshot without evaluating its design, and
+ *  with its state for a warm restart.
+ *
+ *  File layout, in native byte order (checked on load) :
+ *
+ *      snapshot_header
+ *      record_count records of record_size bytes :
+ *          variables       value_type[variable_count]
+ *          feedforward     value_type[order + 1]
+ *          feedback        value_type[order]
+ *          state           state_size bytes, if any
+ *
+ *  design_identity is a hash of the z transfert function, constants
+ *  included, of the sample and value types and of the state layout (see
+ *  snapshot_layout::design_text) : a snapshot is only loaded into filters
+ *  of the same design. It does not depend on the compiler.
+ *
+ *  The coefficients are the ones of the realization, for realizations
+ *  providing coefficients() (direct forms) : coefficients given with
+ *  set_coefficients or process_block_modulated are restored as they were.
+ *  Other realizations (second_order_sections, state_space_block,
+ *  fixed_point) save the coefficients of the design at its variable values.
+ *
+ *  The state is the one of realizations providing state() and set_state()
+ *  (Transposed Direct Form II).
+ */
+struct snapshot_header
+{
+    static constexpr std::uint32_t current_version = 2u;
+    static constexpr std::uint32_t native_byte_order = 0x01020304u;
+    static constexpr char file_magic[8] = {'I', 'I', 'R', 'S', 'N', 'A', 'P', '\0'};
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t design_identity;
+    std::uint32_t sample_size;
+    std::uint32_t value_size;
+    std::uint32_t order;
+    std::uint32_t variable_count;
+    std::uint32_t state_size;
+    std::uint32_t record_size;
+    std::uint64_t record_count;
+};
+
+template <typename Trealization, typename = void>
+struct has_realization_state : std::false_type {};
+
+template <typename Trealization>
+struct has_realization_state<
+    Trealization,
+    std::void_t<decltype(std::declval<Trealization&>().set_state(std::declval<const Trealization&>().state()))>>
+:   std::true_type
+{};
+
+template <typename Trealization, typename = void>
+struct has_realization_coefficients : std::false_type {};
+
+template <typename Trealization>
+struct has_realization_coefficients<
+    Trealization,
+    std::void_t<decltype(std::declval<Trealization&>().set_coefficients(std::declval<const Trealization&>().coefficients()))>>
+:   std::true_type
+{};
+
+/*
+ *  Text of a z transfert function for design_identity : variables are
+ *  written as their index in the variable values, constants with all
+ *  their digits.
+ */
+template <typename Tvars>
+struct snapshot_design_text
+{
+    template <typename Tag>
+    static void write(std::ostream& stream, const variable<Tag>&)
+    {
+        stream << 'v' << type_list_index_of_v<Tvars, Tag>;
+    }
+
+    template <typename T>
+    static void write(std::ostream& stream, const constant<T>& cst)
+    {
+        stream << cst.value;
+    }
+
+    template <typename T, T Value>
+    static void write(std::ostream& stream, const constexpr_constant<T, Value>&)
+    {
+        stream << Value;
+    }
+
+    template <typename Operator, typename E1, typename E2>
+    static void write(std::ostream& stream, const operation<Operator, E1, E2>& e)
+    {
+        stream << '(';
+        write(stream, e.operand1);
+        stream << operator_symbol<Operator>();
+        write(stream, e.operand2);
+        stream << ')';
+    }
+
+    template <typename ...E>
+    static void write(std::ostream& stream, const polynomial<E...>& p)
+    {
+        std::apply([&stream](const auto& ...e) { (..., (write(stream, e), stream << ';')); }, p.coefficients);
+    }
+
+    template <typename Operator>
+    static constexpr char operator_symbol()
+    {
+        if constexpr (std::is_same_v<Operator, sum_operation>)
+            return '+';
+        else if constexpr (std::is_same_v<Operator, sub_operation>)
+            return '-';
+        else if constexpr (std::is_same_v<Operator, product_operation>)
+            return '*';
+        else
+            return '/';
+    }
+};
+
+//  e.g. f32, i16
+template <typename T>
+std::string snapshot_type_text()
+{
+    const char kind = std::is_floating_point_v<T> ? 'f' : (std::is_signed_v<T> ? 'i' : 'u');
+    return kind + std::to_string(8u * sizeof(T));
+}
+
+/**
+ *  Record layout of a filter type
+ */
+template <typename Tfilter>
+struct snapshot_layout
+{
+    using sample_type = typename Tfilter::sample_type;
+    using value_type = typename Tfilter::value_type;
+    using realization_type = typename Tfilter::realization_type;
+    using variable_values_type = typename Tfilter::variable_values_type;
+
+    static constexpr bool has_state = has_realization_state<realization_type>::value;
+
+    static constexpr std::uint32_t order = Tfilter::info::filter_order;
+    static constexpr std::uint32_t variable_count = std::tuple_size_v<variable_values_type>;
+
+    static constexpr std::size_t variables_size = variable_count * sizeof(value_type);
+    static constexpr std::size_t coefficients_size = (2u * order + 1u) * sizeof(value_type);
+
+    static constexpr std::uint32_t state_size()
+    {
+        if constexpr (has_state) {
+            using state_type = std::decay_t<decltype(std::declval<const realization_type&>().state())>;
+            static_assert(std::is_trivially_copyable_v<state_type>);
+            return sizeof(state_type);
+        }
+        else {
+            return 0u;
+        }
+    }
+
+    static constexpr std::uint32_t record_size(bool with_state)
+    {
+        return static_cast<std::uint32_t>(variables_size + coefficients_size + (with_state ? state_size() : 0u));
+    }
+
+    static std::string design_text(const Tfilter& filter)
+    {
+        using text = snapshot_design_text<typename Tfilter::info::var_tags>;
+        const auto& transfert_function = filter.design().transfert_function();
+
+        std::ostringstream stream{};
+        stream.precision(std::numeric_limits<double>::max_digits10);
+        stream
+            << "sample " << snapshot_type_text<sample_type>()
+            << " value " << snapshot_type_text<value_type>()
+            << " state " << state_size()
+            << (has_realization_coefficients<realization_type>::value ? " realization" : " design")
+            << " numerator ";
+        text::write(stream, transfert_function.numerator);
+        stream << " denominator ";
+        text::write(stream, transfert_function.denominator);
+        return stream.str();
+    }
+
+    //  FNV-1a of design_text
+    static std::uint64_t design_identity(const Tfilter& filter)
+    {
+        std::uint64_t hash = 14695981039346656037u;
+        for (const char c : design_text(filter)) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211u;
+        }
+        return hash;
+    }
+
+    static void write_record(Tfilter& filter, unsigned char* record, bool with_state)
+    {
+        const auto values = filter.design().variable_values();
+        const auto& coefficients = record_coefficients(filter);
+
+        std::memcpy(record, values.data(), variables_size);
+        record += variables_size;
+        std::memcpy(record, coefficients.feedforward.data(), (order + 1u) * sizeof(value_type));
+        record += (order + 1u) * sizeof(value_type);
+        std::memcpy(record, coefficients.feedback.data(), order * sizeof(value_type));
+        record += order * sizeof(value_type);
+
+        if constexpr (has_state)
+            if (with_state)
+                std::memcpy(record, &filter.realization().state(), state_size());
+    }
+
+    //  Coefficients the filter runs with, pending variable changes applied
+    static const typename Tfilter::coefficients_type& record_coefficients(Tfilter& filter)
+    {
+        const auto& design_coefficients = filter.coefficients();
+
+        if constexpr (has_realization_coefficients<realization_type>::value)
+            return filter.realization().coefficients();
+        else
+            return design_coefficients;
+    }
+
+    //  Without state in the record, the filter is reset
+    static void read_record(Tfilter& filter, const unsigned char* record, bool with_state)
+    {
+        variable_values_type values{};
+        typename Tfilter::coefficients_type coefficients{};
+
+        std::memcpy(values.data(), record, variables_size);
+        record += variables_size;
+        std::memcpy(coefficients.feedforward.data(), record, (order + 1u) * sizeof(value_type));
+        record += (order + 1u) * sizeof(value_type);
+        std::memcpy(coefficients.feedback.data(), record, order * sizeof(value_type));
+        record += order * sizeof(value_type);
+
+        filter.restore(values, coefficients);
+
+        if constexpr (has_state) {
+            if (with_state) {
+                std::decay_t<decltype(filter.realization().state())> state;
+                std::memcpy(&state, record, state_size());
+                filter.realization().set_state(state);
+                return;
+            }
+        }
+
+        filter.reset();
+    }
+};
+
+/**
+ *  Save every filter of bank. Throws std::runtime_error if the file
+ *  cannot be written.
+ */
+template <typename Tfilter>
+void save_snapshot(const std::string& path, filter_bank<Tfilter>& bank, bool with_state = true)
+{
+    using layout = snapshot_layout<Tfilter>;
+    with_state = with_state && layout::has_state;
+
+    snapshot_header header{};
+    std::memcpy(header.magic, snapshot_header::file_magic, sizeof(header.magic));
+    header.version = snapshot_header::current_version;
+    header.byte_order = snapshot_header::native_byte_order;
+    header.design_identity = (bank.size() != 0u) ? layout::design_identity(bank[0]) : 0u;
+    header.sample_size = sizeof(typename layout::sample_type);
+    header.value_size = sizeof(typename layout::value_type);
+    header.order = layout::order;
+    header.variable_count = layout::variable_count;
+    header.state_size = with_state ? layout::state_size() : 0u;
+    header.record_size = layout::record_size(with_state);
+    header.record_count = bank.size();
+
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<unsigned char> record(header.record_size);
+    for (std::size_t i = 0u; i < bank.size() && file; ++i) {
+        layout::write_record(bank[i], record.data(), with_state);
+        file.write(reinterpret_cast<const char*>(record.data()), static_cast<std::streamsize>(record.size()));
+    }
+
+    file.close();
+    if (!file)
+        throw std::runtime_error{"cannot write snapshot '" + path + "'"};
+}
+
+/**
+ *  A snapshot file, memory mapped where available (read otherwise). The
+ *  header is checked on opening : throws std::runtime_error if the file
+ *  is not a snapshot of this version and byte order, or is truncated.
+ */
+class snapshot_file
+{
+
+public:
+    explicit snapshot_file(const std::string& path)
+    {
+#if defined(SNAPSHOT_USE_MMAP)
+        const int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            error(path, "cannot open");
+
+        struct stat status{};
+        if (::fstat(descriptor, &status) != 0) {
+            ::close(descriptor);
+            error(path, "cannot open");
+        }
+
+        _size = static_cast<std::size_t>(status.st_size);
+        if (_size != 0u) {
+            void* mapping = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(descriptor);
+                error(path, "cannot map");
+            }
+            _data = static_cast<const unsigned char*>(mapping);
+        }
+        ::close(descriptor);
+#else
+        std::ifstream file{path, std::ios::binary};
+        if (!file)
+            error(path, "cannot open");
+        _buffer.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+        _data = _buffer.data();
+        _size = _buffer.size();
+#endif
+
+        if (_size < sizeof(snapshot_header)) {
+            release();
+            error(path, "truncated header in");
+        }
+
+        std::memcpy(&_header, _data, sizeof(_header));
+
+        const char* message = nullptr;
+        if (std::memcmp(_header.magic, snapshot_header::file_magic, sizeof(_header.magic)) != 0)
+            message = "not a snapshot :";
+        else if (_header.version != snapshot_header::current_version)
+            message = "unsupported version of";
+        else if (_header.byte_order != snapshot_header::native_byte_order)
+            message = "foreign byte order in";
+        else if (!has_record_size(_size - sizeof(snapshot_header)))
+            message = "truncated records in";
+
+        if (message != nullptr) {
+            release();
+            error(path, message);
+        }
+    }
+
+    snapshot_file(const snapshot_file&) = delete;
+    snapshot_file& operator=(const snapshot_file&) = delete;
+
+    ~snapshot_file()
+    {
+        release();
+    }
+
+    const snapshot_header& header() const noexcept
+    {
+        return _header;
+    }
+
+    const unsigned char* record(std::size_t index) const noexcept
+    {
+        return _data + sizeof(snapshot_header) + index * _header.record_size;
+    }
+
+private:
+    //  size == record_size * record_count, without overflow on untrusted counts
+    bool has_record_size(std::size_t size) const noexcept
+    {
+        if (_header.record_size == 0u)
+            return size == 0u && _header.record_count == 0u;
+
+        return
+            _header.record_count <= size / _header.record_size &&
+            size == static_cast<std::size_t>(_header.record_count) * _header.record_size;
+    }
+
+    void release() noexcept
+    {
+#if defined(SNAPSHOT_USE_MMAP)
+        if (_data != nullptr)
+            ::munmap(const_cast<unsigned char*>(_data), _size);
+#endif
+        _data = nullptr;
+    }
+
+    [[noreturn]] static void error(const std::string& path, const char* message)
+    {
+        throw std::runtime_error{std::string{message} + " '" + path + "'"};
+    }
+
+    const unsigned char* _data{nullptr};
+    std::size_t _size{0u};
+    snapshot_header _header{};
+#if !defined(SNAPSHOT_USE_MMAP)
+    std::vector<unsigned char> _buffer{};
+#endif
+};
+
+/**
+ *  Restore every filter of bank from file, which must hold one record per
+ *  filter of the same design. Throws std::runtime_error otherwise.
+ */
+template <typename Tfilter>
+void load_snapshot(const snapshot_file& file, filter_bank<Tfilter>& bank)
+{
+    using layout = snapshot_layout<Tfilter>;
+    const auto& header = file.header();
+    const bool with_state = header.state_size != 0u;
+
+    const bool compatible =
+        header.record_count == bank.size() &&
+        header.sample_size == sizeof(typename layout::sample_type) &&
+        header.value_size == sizeof(typename layout::value_type) &&
+        header.order == layout::order &&
+        header.variable_count == layout::variable_count &&
+        (!with_state || header.state_size == layout::state_size()) &&
+        header.record_size == layout::record_size(with_state) &&
+        (bank.size() == 0u || header.design_identity == layout::design_identity(bank[0]));
+
+    if (!compatible)
+        throw std::runtime_error{"snapshot of another design or bank size"};
+
+    for (std::size_t i = 0u; i < bank.size(); ++i)
+        layout::read_record(bank[i], file.record(i), with_state);
+}
+
+template <typename Tfilter>
+void load_snapshot(const std::string& path, filter_bank<Tfilter>& bank)
+{
+    load_snapshot(snapshot_file{path}, bank);
+}
+
+#endif /* SNAPSHOT_H_ */
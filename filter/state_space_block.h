@@ -0,0 +1,267 @@
+#ifndef STATE_SPACE_BLOCK_H_
+#define STATE_SPACE_BLOCK_H_
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "filter_design.h"
+#include "second_order_sections.h"
+
+/**
+ *  State space block realization : BlockSize outputs per iteration.
+ *
+ *  The filter is factored into second order sections (see
+ *  second_order_sections). The state of a section is the history of its
+ *  2 previous inputs and outputs, and unrolling its recursion over a block
+ *  of K samples gives each output of the block directly from the state
+ *  and the block inputs :
+ *
+ *      y[n + i] = sum(j < 2) G(i, j) y[n - 1 - j] + F(i, j) x[n - 1 - j]
+ *               + sum(j <= i) h[i - j] x[n + j]
+ *
+ *  h being the impulse response of the section. The columns of G, F and h
+ *  are precomputed when the coefficients change. A block is then a few
+ *  independent multiply-adds over K lanes instead of a chain of K dependent
+ *  recursion steps, and the next state is the end of the block.
+ *
+ *  Unrolled over a whole high order filter, the same matrices are badly
+ *  conditioned for low cutoff frequencies, which is why sections are used.
+ *  Samples that do not fill a block, and process_one_sample, run the
+ *  recursion one sample at a time.
+ *
+ *  The lanes are GCC / Clang vectors when available : compilers otherwise
+ *  turn the unrolled loops into shuffles rather than K wide multiply-adds.
+ */
+template <unsigned int BlockSize = 8u>
+struct state_space_block
+{
+    static_assert(BlockSize >= 2u && (BlockSize & (BlockSize - 1u)) == 0u, "BlockSize must be a power of two");
+
+    template <typename Tsample, unsigned int Order>
+    class implementation
+    {
+        using factorization_type = typename second_order_sections::template implementation<Tsample, Order>;
+
+    public:
+        using value_type = typename factorization_type::value_type;
+        using coefficients_type = filter_coefficients<value_type, Order>;
+
+        static constexpr auto order = Order;
+        static constexpr auto block_size = BlockSize;
+        static constexpr auto section_count = factorization_type::section_count;
+
+        void set_coefficients(const coefficients_type& coefficients)
+        {
+            if constexpr (Order <= 2u) {
+                //  Already a single section
+                second_order_section<Tsample> section{};
+                section.b0 = static_cast<Tsample>(coefficients.feedforward[0]);
+                section.b1 = static_cast<Tsample>(coefficients.feedforward[1]);
+                section.a1 = static_cast<Tsample>(coefficients.feedback[0]);
+                if constexpr (Order == 2u) {
+                    section.b2 = static_cast<Tsample>(coefficients.feedforward[2]);
+                    section.a2 = static_cast<Tsample>(coefficients.feedback[1]);
+                }
+                _kernels[0].set_section(section);
+            }
+            else {
+                _factorization.set_coefficients(coefficients);
+                for (auto i = 0u; i < section_count; ++i)
+                    _kernels[i].set_section(_factorization.sections()[i]);
+            }
+        }
+
+        Tsample process_one_sample(const Tsample& in)
+        {
+            Tsample value = in;
+            for (auto i = 0u; i < section_count; ++i)
+                value = _kernels[i].process_one_sample(_state[i], value);
+            return value;
+        }
+
+        /**
+         *  The kernels and the state are kept in local copies for the whole
+         *  buffer, so that they are not reloaded after each store to out.
+         */
+        void process_block(const Tsample* in, Tsample* out, std::size_t count)
+        {
+            const kernels_type kernels = _kernels;
+            state_type state = _state;
+            std::size_t i = 0u;
+
+            for (; i + BlockSize <= count; i += BlockSize) {
+                lanes_type values;
+                std::memcpy(&values, in + i, sizeof(lanes_type));
+
+                block_step(std::make_integer_sequence<unsigned int, section_count>{}, kernels, state, values);
+
+                std::memcpy(out + i, &values, sizeof(lanes_type));
+            }
+
+            _state = state;
+
+            for (; i < count; ++i)
+                out[i] = process_one_sample(in[i]);
+        }
+
+        constexpr void reset()
+        {
+            _state = state_type{};
+        }
+
+    private:
+#if defined(__GNUC__)
+        typedef Tsample lanes_type __attribute__((vector_size(sizeof(Tsample) * BlockSize)));
+#else
+        struct lanes_type
+        {
+            Tsample values[BlockSize];
+
+            Tsample& operator[](std::size_t i) { return values[i]; }
+            const Tsample& operator[](std::size_t i) const { return values[i]; }
+
+            friend lanes_type operator*(const lanes_type& lanes, const Tsample& value)
+            {
+                lanes_type result;
+                for (auto i = 0u; i < BlockSize; ++i)
+                    result.values[i] = lanes.values[i] * value;
+                return result;
+            }
+
+            friend lanes_type operator+(const lanes_type& lhs, const lanes_type& rhs)
+            {
+                lanes_type result;
+                for (auto i = 0u; i < BlockSize; ++i)
+                    result.values[i] = lhs.values[i] + rhs.values[i];
+                return result;
+            }
+
+            lanes_type& operator+=(const lanes_type& rhs)
+            {
+                return *this = *this + rhs;
+            }
+        };
+#endif
+
+        //  Matrices are computed in double at least
+        using compute_type = std::common_type_t<Tsample, double>;
+
+        //  x[n - 1], x[n - 2] and y[n - 1], y[n - 2]
+        struct section_state
+        {
+            std::array<Tsample, 2> input_history{};
+            std::array<Tsample, 2> output_history{};
+        };
+
+        class section_kernel
+        {
+
+        public:
+            void set_section(const second_order_section<Tsample>& section)
+            {
+                _section = section;
+
+                for (auto j = 0u; j < 2u; ++j) {
+                    std::array<compute_type, 2> input_history{};
+                    std::array<compute_type, 2> output_history{};
+
+                    output_history[j] = compute_type{1};
+                    block_response(_output_columns[j], output_history, input_history, BlockSize);
+
+                    output_history[j] = compute_type{0};
+                    input_history[j] = compute_type{1};
+                    block_response(_input_history_columns[j], output_history, input_history, BlockSize);
+                }
+
+                //  Response to x[n + j] : the impulse response, delayed by j (zero before j)
+                lanes_type impulse_response;
+                block_response(impulse_response, {}, {}, 0u);
+                for (auto j = 0u; j < BlockSize; ++j)
+                    for (auto i = j; i < BlockSize; ++i)
+                        _input_columns[j][i] = impulse_response[i - j];
+            }
+
+            Tsample process_one_sample(section_state& state, const Tsample& in) const
+            {
+                const Tsample out =
+                    _section.b0 * in + _section.b1 * state.input_history[0] + _section.b2 * state.input_history[1] -
+                    _section.a1 * state.output_history[0] - _section.a2 * state.output_history[1];
+
+                state.input_history = {in, state.input_history[0]};
+                state.output_history = {out, state.output_history[0]};
+                return out;
+            }
+
+            /*
+             *  values : block inputs, replaced by the block outputs. The inputs
+             *  are accumulated first, and the state terms last : the state is
+             *  the only dependency between blocks, so that keeps the chain from
+             *  one block to the next short.
+             */
+            void block_step(section_state& state, lanes_type& values) const
+            {
+                lanes_type output = _input_columns[0] * values[0];
+                for (auto j = 1u; j < BlockSize; ++j)
+                    output += _input_columns[j] * values[j];
+
+                output +=
+                    (_output_columns[0] * state.output_history[0] + _output_columns[1] * state.output_history[1]) +
+                    (_input_history_columns[0] * state.input_history[0] + _input_history_columns[1] * state.input_history[1]);
+
+                state.input_history = {values[BlockSize - 1u], values[BlockSize - 2u]};
+                state.output_history = {output[BlockSize - 1u], output[BlockSize - 2u]};
+                values = output;
+            }
+
+        private:
+            //  Block outputs from a history, with a unit input at impulse_position (none if BlockSize)
+            void block_response(
+                lanes_type& result,
+                std::array<compute_type, 2> output_history,
+                std::array<compute_type, 2> input_history,
+                unsigned int impulse_position) const
+            {
+                for (auto i = 0u; i < BlockSize; ++i) {
+                    const compute_type in = (i == impulse_position) ? compute_type{1} : compute_type{0};
+                    const compute_type out =
+                        static_cast<compute_type>(_section.b0) * in +
+                        static_cast<compute_type>(_section.b1) * input_history[0] +
+                        static_cast<compute_type>(_section.b2) * input_history[1] -
+                        static_cast<compute_type>(_section.a1) * output_history[0] -
+                        static_cast<compute_type>(_section.a2) * output_history[1];
+
+                    input_history = {in, input_history[0]};
+                    output_history = {out, output_history[0]};
+                    result[i] = static_cast<Tsample>(out);
+                }
+            }
+
+            second_order_section<Tsample> _section{};
+
+            //  Plain arrays : vector types lose their attribute as template arguments
+            lanes_type _output_columns[2]{};
+            lanes_type _input_history_columns[2]{};
+            lanes_type _input_columns[BlockSize]{};
+        };
+
+        using kernels_type = std::array<section_kernel, section_count>;
+        using state_type = std::array<section_state, section_count>;
+
+        template <unsigned int ...Sections>
+        static void block_step(
+            const std::integer_sequence<unsigned int, Sections...>&,
+            const kernels_type& kernels, state_type& state, lanes_type& values)
+        {
+            (..., kernels[Sections].block_step(state[Sections], values));
+        }
+
+        kernels_type _kernels{};
+        state_type _state{};
+        factorization_type _factorization{};
+    };
+};
+
+#endif /* STATE_SPACE_BLOCK_H_ */
@@ -0,0 +1,391 @@
+#ifndef VOICE_BANK_H_
+#define VOICE_BANK_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../bilinear_transform/bilinear_transform.h"
+#include "../expression/common_subexpression.h"
+#include "../utils/type_list.h"
+#include "../utils/variable_store.h"
+#include "filter_design.h"
+#include "realization.h"
+
+/**
+ *  Lane pack : Lanes values processed together, with element-wise
+ *  operators. Scalar operands (constants of the expressions) are broadcast.
+ *  The loops over the lanes are mapped to SIMD registers by the compiler.
+ */
+template <typename T, std::size_t Lanes>
+struct alignas(std::min<std::size_t>(Lanes * sizeof(T), 64u)) lane_pack
+{
+    static constexpr auto lane_count = Lanes;
+
+    static constexpr lane_pack broadcast(const T& value) noexcept
+    {
+        lane_pack result{};
+        for (std::size_t lane = 0u; lane < Lanes; ++lane)
+            result.values[lane] = value;
+        return result;
+    }
+
+    constexpr T& operator[](std::size_t lane) noexcept { return values[lane]; }
+    constexpr const T& operator[](std::size_t lane) const noexcept { return values[lane]; }
+
+    T values[Lanes]{};
+};
+
+template <typename T>
+struct is_lane_pack : std::false_type {};
+
+template <typename T, std::size_t Lanes>
+struct is_lane_pack<lane_pack<T, Lanes>> : std::true_type {};
+
+//  Pack, or scalar to broadcast
+template <typename T, std::size_t Lanes, typename U>
+constexpr lane_pack<T, Lanes> to_lane_pack(const U& value) noexcept
+{
+    if constexpr (is_lane_pack<U>::value)
+        return value;
+    else
+        return lane_pack<T, Lanes>::broadcast(static_cast<T>(value));
+}
+
+template <typename T1, typename T2>
+using lane_pack_result_t = std::conditional_t<is_lane_pack<T1>::value, T1, T2>;
+
+template <typename T1, typename T2>
+using enable_if_lane_pack_t =
+    std::enable_if_t<
+        (is_lane_pack<T1>::value && (is_lane_pack<T2>::value || std::is_arithmetic_v<T2>)) ||
+        (std::is_arithmetic_v<T1> && is_lane_pack<T2>::value)>;
+
+//  Element-wise op, one of the operands at least being a pack
+template <typename T1, typename T2, typename Operator>
+constexpr lane_pack_result_t<T1, T2> lane_wise(const T1& v1, const T2& v2, const Operator& op) noexcept
+{
+    using pack_type = lane_pack_result_t<T1, T2>;
+    using value_type = std::decay_t<decltype(std::declval<pack_type>()[0])>;
+
+    const auto p1 = to_lane_pack<value_type, pack_type::lane_count>(v1);
+    const auto p2 = to_lane_pack<value_type, pack_type::lane_count>(v2);
+    pack_type result{};
+    for (std::size_t lane = 0u; lane < pack_type::lane_count; ++lane)
+        result.values[lane] = op(p1.values[lane], p2.values[lane]);
+    return result;
+}
+
+template <typename T1, typename T2, typename = enable_if_lane_pack_t<T1, T2>>
+constexpr auto operator+(const T1& v1, const T2& v2) noexcept { return lane_wise(v1, v2, std::plus<>{}); }
+
+template <typename T1, typename T2, typename = enable_if_lane_pack_t<T1, T2>>
+constexpr auto operator-(const T1& v1, const T2& v2) noexcept { return lane_wise(v1, v2, std::minus<>{}); }
+
+template <typename T1, typename T2, typename = enable_if_lane_pack_t<T1, T2>>
+constexpr auto operator*(const T1& v1, const T2& v2) noexcept { return lane_wise(v1, v2, std::multiplies<>{}); }
+
+template <typename T1, typename T2, typename = enable_if_lane_pack_t<T1, T2>>
+constexpr auto operator/(const T1& v1, const T2& v2) noexcept { return lane_wise(v1, v2, std::divides<>{}); }
+
+/**
+ *  Voice bank : many instances (voices) of the same design, each one with
+ *  its own variable values and stream, e.g. the per-voice filters of a
+ *  synthesizer.
+ *
+ *  Voices are stored by groups of Lanes, each quantity of a group (a
+ *  variable, a coefficient, a state variable) being a lane_pack :
+ *
+ *      group g : variables[V]      voices g * Lanes ... g * Lanes + Lanes - 1
+ *                feedforward[N + 1]
+ *                feedback[N]
+ *                state[N]
+ *
+ *  The coefficients of a group are evaluated at once, the transfert
+ *  function being evaluated on lane packs, and only for the groups whose
+ *  variables changed. The Transposed Direct Form II recursion then runs
+ *  the voices of a group in lanes, each lane with its own coefficients.
+ *
+ *  Input and output are planar : one buffer per voice. The lanes of the
+ *  last group beyond voice_count are processed but never read : they take
+ *  the variables of the last voice, so that they run with finite
+ *  coefficients. As with make_filter, the variables of every voice are
+ *  to be set before processing (e.g. T = 0 gives NaN coefficients).
+ */
+
+template <typename T>
+constexpr std::size_t default_voice_lanes = 64u / sizeof(T);
+
+template <typename Tsample, typename Tztransform, std::size_t Lanes = default_voice_lanes<Tsample>>
+class voice_bank;
+
+template <typename Tsample, typename Pnumerator, typename Pdenominator, std::size_t Lanes>
+class voice_bank<Tsample, rational_fraction<Pnumerator, Pdenominator>, Lanes>
+{
+
+public:
+    using Tztransform = rational_fraction<Pnumerator, Pdenominator>;
+    using info = ztransform_info<Tztransform>;
+    using sample_type = Tsample;
+    using value_type = Tsample;
+    using coefficients_type = filter_coefficients<value_type, info::filter_order>;
+    using pack_type = lane_pack<value_type, Lanes>;
+
+    static constexpr auto lane_count = Lanes;
+
+    voice_bank(const Tztransform& transfert_function, std::size_t voice_count)
+    :   _transfert_function{transfert_function},
+        _voice_count{voice_count},
+        _groups((voice_count + Lanes - 1u) / Lanes)
+    {}
+
+    std::size_t size() const noexcept
+    {
+        return _voice_count;
+    }
+
+    /**
+     *  Process count samples of every voice : in[v] and out[v] are the
+     *  buffers of voice v. in and out may be the same buffers.
+     */
+    void process_block(const Tsample* const* in, Tsample* const* out, std::size_t count)
+    {
+        for (std::size_t g = 0u; g < _groups.size(); ++g) {
+            auto& group = _groups[g];
+            if (group.coefficients_outdated)
+                update_coefficients(group, group_voice_count(g));
+
+            const auto first = g * Lanes;
+            process_group(group, in + first, out + first, group_voice_count(g), count);
+        }
+    }
+
+    void process_block(Tsample* const* inout, std::size_t count)
+    {
+        process_block(inout, inout, count);
+    }
+
+    template <typename SearchTag>
+    void set_variable(const variable<SearchTag>&, std::size_t voice, const value_type& value)
+    {
+        auto& group = _groups[voice / Lanes];
+        group.variables[variable_index<SearchTag>][voice % Lanes] = value;
+        group.coefficients_outdated = true;
+    }
+
+    //  Batched : values[v] for voice v, every voice
+    template <typename SearchTag>
+    void set_variable(const variable<SearchTag>&, const value_type* values)
+    {
+        for (std::size_t g = 0u; g < _groups.size(); ++g) {
+            auto& group = _groups[g];
+            std::copy_n(values + g * Lanes, group_voice_count(g), group.variables[variable_index<SearchTag>].values);
+            group.coefficients_outdated = true;
+        }
+    }
+
+    template <typename SearchTag>
+    value_type get_variable(const variable<SearchTag>&, std::size_t voice) const
+    {
+        return _groups[voice / Lanes].variables[variable_index<SearchTag>][voice % Lanes];
+    }
+
+    //  Normalized coefficients of one voice
+    coefficients_type coefficients(std::size_t voice)
+    {
+        auto& group = _groups[voice / Lanes];
+        if (group.coefficients_outdated)
+            update_coefficients(group, group_voice_count(voice / Lanes));
+
+        const auto lane = voice % Lanes;
+        coefficients_type result{};
+        for (std::size_t k = 0u; k <= filter_order; ++k)
+            result.feedforward[k] = group.feedforward[k][lane];
+        for (std::size_t k = 0u; k < filter_order; ++k)
+            result.feedback[k] = group.feedback[k][lane];
+        return result;
+    }
+
+    //  e.g. on note on
+    void reset(std::size_t voice)
+    {
+        auto& group = _groups[voice / Lanes];
+        for (auto& state : group.state)
+            state[voice % Lanes] = value_type{0};
+    }
+
+    void reset()
+    {
+        for (auto& group : _groups)
+            group.state = state_type{};
+    }
+
+private:
+    static constexpr auto filter_order = info::filter_order;
+    static constexpr std::size_t tile_size = 32u;
+
+    //    store_type = variable_store<pack_type, Tags...>
+    using store_type =
+        type_list_instanciate_t<
+            type_list_append_t<typename info::var_tags, pack_type>, variable_store>;
+
+    using cache_type = subexpression_cache<pack_type, typename info::shared_subexpressions>;
+    using variables_type = decltype(std::declval<store_type>().values());
+    using state_type = std::array<pack_type, filter_order>;
+
+    template <typename SearchTag>
+    static constexpr auto variable_index = type_list_index_of_v<typename info::var_tags, SearchTag>;
+
+    struct lane_group
+    {
+        variables_type variables{};
+        std::array<pack_type, filter_order + 1> feedforward{};
+        std::array<pack_type, filter_order> feedback{};
+        state_type state{};
+        bool coefficients_outdated{true};
+    };
+
+    std::size_t group_voice_count(std::size_t group) const noexcept
+    {
+        return std::min(Lanes, _voice_count - group * Lanes);
+    }
+
+    //  As filter_design::update_coefficients, on the lanes of a group whose first voices are voices
+    void update_coefficients(lane_group& group, std::size_t voices) const
+    {
+        for (auto& values : group.variables)
+            for (std::size_t lane = voices; lane < Lanes; ++lane)
+                values[lane] = values[voices - 1u];
+
+        store_type store{};
+        cache_type cache{};
+        store.set_values(group.variables);
+        cache.update(store);
+
+        const auto eval = [&](const auto& e) { return to_lane_pack<value_type, Lanes>(cache.eval(store, e)); };
+        const pack_type inv_output_divider =
+            value_type{1} / eval(std::get<filter_order>(_transfert_function.denominator.coefficients));
+
+        update_feedforward(std::make_integer_sequence<unsigned int, filter_order + 1>{}, group, eval, inv_output_divider);
+        update_feedback(std::make_integer_sequence<unsigned int, filter_order>{}, group, eval, inv_output_divider);
+        group.coefficients_outdated = false;
+    }
+
+    //  feedforward[k] = n[N - k] / d[N]
+    template <unsigned int ...Indexes, typename Eval>
+    void update_feedforward(
+        const std::integer_sequence<unsigned int, Indexes...>&,
+        lane_group& group, const Eval& eval, const pack_type& inv_output_divider) const
+    {
+        (..., (group.feedforward[Indexes] = numerator_coefficient<filter_order - Indexes>(eval) * inv_output_divider));
+    }
+
+    //  feedback[k - 1] = d[N - k] / d[N]
+    template <unsigned int ...Indexes, typename Eval>
+    void update_feedback(
+        const std::integer_sequence<unsigned int, Indexes...>&,
+        lane_group& group, const Eval& eval, const pack_type& inv_output_divider) const
+    {
+        (..., (group.feedback[Indexes] =
+            eval(std::get<filter_order - 1 - Indexes>(_transfert_function.denominator.coefficients)) * inv_output_divider));
+    }
+
+    template <unsigned int Degree, typename Eval>
+    pack_type numerator_coefficient(const Eval& eval) const
+    {
+        if constexpr (Degree <= Pnumerator::degree())
+            return eval(std::get<Degree>(_transfert_function.numerator.coefficients));
+        else
+            return pack_type{};
+    }
+
+    //  Voices are transposed to lanes by tiles, the state staying in local copies
+    static void process_group(
+        lane_group& group, const Tsample* const* in, Tsample* const* out,
+        std::size_t lanes, std::size_t count)
+    {
+        const auto feedforward = group.feedforward;
+        const auto feedback = group.feedback;
+        auto state = group.state;
+        pack_type tile_in[tile_size]{};
+        pack_type tile_out[tile_size];
+
+        for (std::size_t begin = 0u; begin < count; begin += tile_size) {
+            const auto size = std::min(tile_size, count - begin);
+
+            for (std::size_t lane = 0u; lane < lanes; ++lane)
+                for (std::size_t i = 0u; i < size; ++i)
+                    tile_in[i][lane] = in[lane][begin + i];
+
+            for (std::size_t i = 0u; i < size; ++i)
+                tile_out[i] = step(
+                    std::make_integer_sequence<unsigned int, filter_order - 1>{},
+                    feedforward, feedback, state, tile_in[i]);
+
+            for (std::size_t lane = 0u; lane < lanes; ++lane)
+                for (std::size_t i = 0u; i < size; ++i)
+                    out[lane][begin + i] = tile_out[i][lane];
+        }
+
+        group.state = state;
+    }
+
+    //  Transposed Direct Form II (see realization.h), each lane with its own coefficients
+    template <unsigned int ...Indexes>
+    static pack_type step(
+        const std::integer_sequence<unsigned int, Indexes...>&,
+        const std::array<pack_type, filter_order + 1>& feedforward,
+        const std::array<pack_type, filter_order>& feedback,
+        state_type& state,
+        const pack_type& in)
+    {
+        pack_type out;
+        for (std::size_t lane = 0u; lane < Lanes; ++lane)
+            out[lane] = feedforward[0][lane] * in[lane] + state[0][lane];
+
+        (..., update_state(state[Indexes], state[Indexes + 1], feedforward[Indexes + 1], feedback[Indexes], in, out));
+
+        //  See transposed_direct_form_2::step
+        for (std::size_t lane = 0u; lane < Lanes; ++lane)
+            state[filter_order - 1][lane] = subtract_product(
+                feedforward[filter_order][lane] * in[lane], feedback[filter_order - 1][lane], out[lane]);
+
+        return out;
+    }
+
+    static void update_state(
+        pack_type& state, const pack_type& next_state,
+        const pack_type& feedforward, const pack_type& feedback,
+        const pack_type& in, const pack_type& out)
+    {
+        for (std::size_t lane = 0u; lane < Lanes; ++lane)
+            state[lane] = next_state[lane] + feedforward[lane] * in[lane] - feedback[lane] * out[lane];
+    }
+
+    const Tztransform _transfert_function;
+    std::size_t _voice_count;
+    std::vector<lane_group> _groups;
+};
+
+/**
+ *  Build a voice bank from a laplace transfert function, as make_filter :
+ *  bound variables are folded into the coefficients of every voice.
+ */
+template <
+    typename Tsample, std::size_t Lanes = default_voice_lanes<Tsample>,
+    typename E, typename ...Tags, typename ...Ts>
+auto make_voice_bank(
+    const expression<E>& laplace_transfert_function, std::size_t voice_count,
+    const variable_binding<Tags, Ts>& ...bindings)
+{
+    const auto z_transfert_function = bind_variables(bilinear_transform(laplace_transfert_function), bindings...);
+    using z_transform_type = std::decay_t<decltype(z_transfert_function)>;
+    return voice_bank<Tsample, z_transform_type, Lanes>{z_transfert_function, voice_count};
+}
+
+#endif /* VOICE_BANK_H_ */
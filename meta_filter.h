@@ -1,181 +1,342 @@
 #ifndef META_FILTER_H_
 #define META_FILTER_H_
 
+#include <algorithm>
 #include <utility>
 #include <array>
+#include <cstddef>
 
 #include "bilinear_transform/bilinear_transform.h"
-#include "expression/evaluate.h"
-#include "utils/type_list.h"
-#include "utils/variable_set.h"
-
-/**
- * Variable store
- */
-template <typename Tag, typename T>
-struct variable_association {
-    T value{};
-};
+#include "filter/filter_design.h"
+#include "filter/coefficient_table.h"
+#include "filter/frequency_response.h"
+#include "filter/parameter_smoother.h"
+#include "filter/realization.h"
+#include "filter/second_order_sections.h"
+#include "filter/state_space_block.h"
+#include "filter/fixed_point.h"
+#include "filter/multichannel_filter.h"
+#include "filter/multirate.h"
+#include "filter/filter_bank.h"
+#include "filter/parallel_in_time.h"
+#include "filter/instrumentation.h"
+#include "filter/runtime_filter.h"
+#include "filter/snapshot.h"
+#include "filter/filter_graph.h"
+#include "filter/voice_bank.h"
+#include "filter/parameter_channel.h"
+
+template <
+    typename Tsample, typename Tztransform,
+    typename Realization = transposed_direct_form_2, typename Instrumentation = no_instrumentation>
+struct iir_filter_implementation;
 
-template <typename T, typename ...Tag>
-class variable_store : variable_association<Tag, T>...
+template <typename Tsample, typename Pnumerator, typename Pdenominator, typename Realization, typename Instrumentation>
+struct iir_filter_implementation<Tsample, rational_fraction<Pnumerator, Pdenominator>, Realization, Instrumentation>
 {
+    using Tztransform = rational_fraction<Pnumerator, Pdenominator>;
+    using info = ztransform_info<Tztransform>;
+    using realization_type = typename Realization::template implementation<Tsample, info::filter_order>;
+    using sample_type = Tsample;
+    using value_type = typename realization_type::value_type;
+    using design_type = filter_design<value_type, Tztransform>;
+    using coefficients_type = typename design_type::coefficients_type;
+    using variable_values_type = typename design_type::variable_values_type;
+
+    //    smoother_type = parameter_smoother<value_type, Tags...>
+    using smoother_type =
+        type_list_instanciate_t<
+            type_list_append_t<typename info::var_tags, value_type>, parameter_smoother>;
 
 public:
-    constexpr variable_store() = default;
-
-    template <typename Searchtag>
-    constexpr auto get() const
+    constexpr iir_filter_implementation(const Tztransform& transfert_function)
+    :   _design{transfert_function}
     {
-        return variable_association<Searchtag, T>::value;
+        //  Without variables, the coefficients are known from the start
+        if constexpr (!has_variables)
+            _realization.set_coefficients(_design.coefficients());
     }
 
-    template <typename Searchtag>
-    constexpr void set(const T& val)
+    Tsample process_one_sample(const Tsample& in)
     {
-        variable_association<Searchtag, T>::value = val;
+        next_smoothing_block(1u);
+        update_coefficients();
+        const Tsample out = _realization.process_one_sample(in);
+
+        if constexpr (Instrumentation::enabled)
+            _instrumentation.record_sample(out);
+        return out;
     }
 
-    template <typename E>
-    constexpr auto subsitute_variables(const expression<E>& e) const
+    /**
+     *  Process count samples. Coefficients are checked once and the
+     *  state is kept in local copies for the whole block (or for each
+     *  sub-block while variables are smoothed).
+     *  in and out may be the same buffer.
+     */
+    void process_block(const Tsample* in, Tsample* out, std::size_t count)
     {
-        return substitute_var_impl<E, Tag...>::subst(*this, e);
+        measure_block(out, count,
+            [&]()
+            {
+                do {
+                    const auto size = next_smoothing_block(count);
+                    update_coefficients();
+                    _realization.process_block(in, out, size);
+                    in += size;
+                    out += size;
+                    count -= size;
+                } while (count != 0u);
+            });
     }
 
-    template <typename E>
-    constexpr auto eval(const expression<E>& e)
+    void process_block(Tsample* inout, std::size_t count)
     {
-        return evaluate(subsitute_variables(e));
+        process_block(inout, inout, count);
     }
 
-private:
-    
-    template <typename E, typename ...Tags>
-    struct substitute_var_impl;
+    /**
+     *  Offline processing of a long signal, split over thread_count threads
+     *  (see parallel_in_time.h). Transposed Direct Form II only. Smoothed
+     *  variables fall back to process_block.
+     */
+    void process_offline(
+        const Tsample* in, Tsample* out, std::size_t count,
+        std::size_t thread_count = std::thread::hardware_concurrency())
+    {
+        static_assert(std::is_same_v<Realization, transposed_direct_form_2>);
+
+        if (_smoother.active()) {
+            process_block(in, out, count);
+        }
+        else {
+            update_coefficients();
+            measure_block(out, count,
+                [&]() { process_parallel_in_time(_realization, in, out, count, thread_count); });
+        }
+    }
 
-    template <typename E>
-    struct substitute_var_impl<E>
+    template <typename SearchTag>
+    constexpr void set_variable(const variable<SearchTag>& var, const value_type& value)
     {
-        static constexpr auto subst(const variable_store&, const expression<E>& e) { return E{e}; }
-    };
+        if constexpr (Instrumentation::enabled)
+            _instrumentation.record_variable_change();
+
+        _smoother.template stop<SearchTag>();
+        _design.set_variable(var, value);
+    }
 
-    template <typename E, typename FirstTag, typename ...LastTags>
-    struct substitute_var_impl<E, FirstTag, LastTags...>
+    /**
+     *  Set all the variables at once (see parameter_channel.h), in the
+     *  order of design_type::variable_values_type. Smoothing ramps are stopped.
+     */
+    constexpr void set_variable_values(const variable_values_type& values)
     {
-        static constexpr auto subst(const variable_store& store, const expression<E>& e)
-        {
-            const auto tmp_expr = substitute(e, variable<FirstTag>{}, store.get<FirstTag>());
-            using tmp_expr_type = std::decay_t<decltype(tmp_expr)>;
-            return substitute_var_impl<tmp_expr_type, LastTags...>::subst(store, tmp_expr);
-        }
-    };
-};
+        if constexpr (Instrumentation::enabled)
+            _instrumentation.record_variable_change();
 
-/**
- *
- */
+        _smoother = smoother_type{};
+        _samples_before_update = 0u;
+        _design.set_variable_values(values);
+    }
 
-template <typename Tztransform>
-struct ztransform_info;
+    /**
+     *  Smoothing : variables set with set_variable_target move linearly
+     *  to their target over ramp_length samples. Coefficients are
+     *  re-evaluated every update_interval samples during the ramp.
+     */
+    constexpr void set_smoothing(std::size_t ramp_length, std::size_t update_interval = 32u)
+    {
+        _smoothing_length = ramp_length;
+        _smoothing_interval = std::max<std::size_t>(update_interval, 1u);
+    }
 
-template <typename P1, typename P2>
-struct ztransform_info<rational_fraction<P1, P2>>
-{
-    static_assert (P1::degree() <= P2::degree());
-    static constexpr auto filter_order = P2::degree();
-    using var_tags = variable_set_t<rational_fraction<P1, P2>>;
-};
+    template <typename SearchTag>
+    constexpr void set_variable_target(const variable<SearchTag>& var, const value_type& target)
+    {
+        if (_smoothing_length == 0u) {
+            set_variable(var, target);
+        }
+        else {
+            _smoother.template set_target<SearchTag>(_design.get_variable(var), target, _smoothing_length);
+            _samples_before_update = 0u;
+        }
+    }
 
-//-
+    /**
+     *  Coefficients given directly (e.g. from a coefficient_table) are used
+     *  until a variable changes.
+     */
+    constexpr void set_coefficients(const coefficients_type& coefficients)
+    {
+        //  Consume the pending design update, so that it does not override these coefficients
+        if (_design.coefficients_outdated())
+            _design.coefficients();
+        _realization.set_coefficients(coefficients);
+    }
 
-template <typename Tsample, typename Tztransform>
-struct iir_filter_implementation;
+    /**
+     *  Normalized coefficients of the design at its current variable values
+     */
+    const coefficients_type& coefficients()
+    {
+        update_coefficients();
+        return _design.coefficients();
+    }
 
-template <typename Tsample, typename Pnumerator, typename Pdenominator>
-struct iir_filter_implementation<Tsample, rational_fraction<Pnumerator, Pdenominator>>
-{
-    using Tztransform = rational_fraction<Pnumerator, Pdenominator>;
-    using info = ztransform_info<Tztransform>;
+    /**
+     *  Restore the variables and coefficients saved from a filter of the
+     *  same design (see snapshot.h), without evaluating the transfert
+     *  function. Smoothing ramps are stopped.
+     */
+    constexpr void restore(const variable_values_type& values, const coefficients_type& coefficients)
+    {
+        _smoother = smoother_type{};
+        _samples_before_update = 0u;
+        _design.restore(values, coefficients);
+        _realization.set_coefficients(coefficients);
+    }
 
-    //    variable_store_t = variable_store<Tsample, Tags...>  
-    using variable_store_t = 
-        type_list_instanciate_t<
-            type_list_append_t<typename info::var_tags, Tsample>, variable_store>;
+    /**
+     *  Process count samples, the coefficients of sample i being looked up
+     *  in table for the value modulation[i]. Meant for realizations whose
+     *  set_coefficients is a copy (direct forms).
+     */
+    template <typename Ttable>
+    void process_block_modulated(
+        const Tsample* in, Tsample* out, std::size_t count,
+        const value_type* modulation, const Ttable& table)
+    {
+        measure_block(out, count,
+            [&]()
+            {
+                for (std::size_t i = 0u; i < count; ++i) {
+                    set_coefficients(table(modulation[i]));
+                    out[i] = _realization.process_one_sample(in[i]);
+                }
+            });
+    }
 
-public:
-    constexpr iir_filter_implementation(const Tztransform& transfert_function)
-    :   _transfert_function{transfert_function}
-    {}
+    /**
+     *  Frequency response of the design at its current variable values,
+     *  from the same coefficients as the realization (see frequency_response.h).
+     */
+    void frequency_response(
+        const value_type* frequencies, std::size_t count,
+        value_type* magnitude, value_type* phase = nullptr, value_type* group_delay = nullptr)
+    {
+        update_coefficients();
+        ::frequency_response(_design.coefficients(), frequencies, count, magnitude, phase, group_delay);
+    }
 
-    Tsample process_one_sample(const Tsample& in)
+    constexpr const design_type& design() const noexcept
     {
-        const auto output_divider_expr = std::get<Pdenominator::degree()>(_transfert_function.denominator.coefficients);
-        const auto output_divider_val = _variable_store.eval(output_divider_expr);
+        return _design;
+    }
 
-        const auto out = 
-            sum_helper(
-                std::make_integer_sequence<unsigned int, Pnumerator::degree() + 1>{},
-                std::make_integer_sequence<unsigned int, Pdenominator::degree()>{}, in)
-            / output_divider_val;
+    //  e.g. for the state of the realizations providing state() and set_state()
+    constexpr const realization_type& realization() const noexcept
+    {
+        return _realization;
+    }
 
-        enqueue(in, out);
-        return out;
+    constexpr realization_type& realization() noexcept
+    {
+        return _realization;
     }
 
-    template <typename SearchTag>
-    constexpr void set_variable(const variable<SearchTag>&, const Tsample& value)
+    /**
+     *  Counters of this instance, with a filter_instrumentation policy :
+     *  instrumentation().snapshot() can be read from any thread.
+     */
+    constexpr const Instrumentation& instrumentation() const noexcept
     {
-        _variable_store.template set<SearchTag>(value);
+        return _instrumentation;
     }
 
-private:
+    constexpr Instrumentation& instrumentation() noexcept
+    {
+        return _instrumentation;
+    }
 
-    template <unsigned int Idx>
-    constexpr auto get_input(const Tsample& current_in)
+    constexpr void reset()
     {
-        if constexpr (Idx == info::filter_order)
-            return current_in;
-        else
-            return _prev_input_queue[Idx];
+        _realization.reset();
     }
 
-    template <unsigned int ...FeedforwardIndexes, unsigned int ...FeedbackIndexes>
-    constexpr Tsample sum_helper(
-        const std::integer_sequence<unsigned int, FeedforwardIndexes...>&,
-        const std::integer_sequence<unsigned int, FeedbackIndexes...>&,
-        const Tsample& in)
+private:
+    //  Number of samples to process before the smoothed variables must be advanced
+    constexpr std::size_t next_smoothing_block(std::size_t count)
     {
-        const auto output_expr = 
-            ((... + (std::get<FeedforwardIndexes>(_transfert_function.numerator.coefficients) * get_input<FeedforwardIndexes>(in))) -
-            (... + (std::get<FeedbackIndexes>(_transfert_function.denominator.coefficients) * _prev_output_queue[FeedbackIndexes])));
+        if (!_smoother.active())
+            return count;
+
+        if (_samples_before_update == 0u) {
+            _smoother.advance(_design, _smoothing_interval);
+            _samples_before_update = _smoothing_interval;
+        }
 
-        return
-            _variable_store.eval(output_expr);
+        const auto size = std::min(count, _samples_before_update);
+        _samples_before_update -= size;
+        return size;
     }
 
-    constexpr void enqueue(const Tsample& in, const Tsample& out)
+    constexpr void update_coefficients()
     {
-        //  TO BE optimized with a circular buffer
-        for (auto i = 0; i < (info::filter_order - 1); ++i)
-            _prev_input_queue[i] = _prev_input_queue[i + 1];
-        for (auto i = 0; i < (info::filter_order - 1); ++i)
-            _prev_output_queue[i] = _prev_output_queue[i + 1];
-        _prev_input_queue[info::filter_order - 1] = in;
-        _prev_output_queue[info::filter_order - 1] = out;
+        if constexpr (has_variables) {
+            if (_design.coefficients_outdated()) {
+                if constexpr (Instrumentation::enabled) {
+                    const auto start = Instrumentation::clock::now();
+                    _realization.set_coefficients(_design.coefficients());
+                    _instrumentation.record_coefficient_update(Instrumentation::clock::now() - start);
+                }
+                else {
+                    _realization.set_coefficients(_design.coefficients());
+                }
+            }
+        }
     }
 
-    const Tztransform _transfert_function;
-    variable_store_t _variable_store{};
-    std::array<Tsample, info::filter_order> _prev_input_queue{};
-    std::array<Tsample, info::filter_order> _prev_output_queue{};
+    //  Run process, which writes count samples to out, timed when instrumented
+    template <typename Function>
+    void measure_block(const Tsample* out, std::size_t count, const Function& process)
+    {
+        if constexpr (Instrumentation::enabled) {
+            const auto start = Instrumentation::clock::now();
+            process();
+            _instrumentation.record_block(Instrumentation::clock::now() - start, out, count);
+        }
+        else {
+            process();
+        }
+    }
+
+    static constexpr auto has_variables = !std::is_same_v<typename info::var_tags, type_list<>>;
+
+    design_type _design;
+    realization_type _realization{};
+    smoother_type _smoother{};
+    std::size_t _smoothing_length{0u};
+    std::size_t _smoothing_interval{32u};
+    std::size_t _samples_before_update{0u};
+    Instrumentation _instrumentation{};
 };
 
-template <typename Tsample, typename E>
-constexpr auto make_filter(const expression<E>& laplace_transfert_function)
+/**
+ *  Build a filter from a laplace transfert function. Variables bound with
+ *  bind(var, value) are folded into the coefficients, only the others can
+ *  be set at runtime. The whole construction is a constant expression :
+ *  a filter whose variables are all bound can be constant initialized
+ *  (constinit in C++20) with its coefficients already computed.
+ */
+template <
+    typename Tsample, typename Realization = transposed_direct_form_2, typename Instrumentation = no_instrumentation,
+    typename E, typename ...Tags, typename ...Ts>
+constexpr auto make_filter(const expression<E>& laplace_transfert_function, const variable_binding<Tags, Ts>& ...bindings)
 {
-    const auto z_transfert_function = bilinear_transform(laplace_transfert_function);    
+    const auto z_transfert_function = bind_variables(bilinear_transform(laplace_transfert_function), bindings...);
     using z_transform_type = std::decay_t<decltype(z_transfert_function)>;
-    return iir_filter_implementation<Tsample, z_transform_type>{z_transfert_function};
+    return iir_filter_implementation<Tsample, z_transform_type, Realization, Instrumentation>{z_transfert_function};
 }
 
-#endif /* META_FILTER_H_ */
\ No newline at end of file
+#endif /* META_FILTER_H_ */
@@ -0,0 +1,82 @@
+#ifndef TRIPLE_BUFFER_H_
+#define TRIPLE_BUFFER_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ *  Triple buffer : wait-free transfer of the latest value of T from one
+ *  producer thread to one consumer thread.
+ *
+ *  The producer owns the back slot and the consumer the front slot. The
+ *  third slot (middle) is exchanged atomically : publish() swaps the back
+ *  slot with it, marked fresh, and update() swaps it with the front slot
+ *  if it is fresh. Neither side ever waits for the other, and values
+ *  published in between two updates are skipped, only the latest one
+ *  being read.
+ */
+template <typename T>
+class triple_buffer
+{
+
+public:
+    static constexpr std::size_t cache_line_size = 64u;
+
+    triple_buffer() = default;
+
+    explicit triple_buffer(const T& value)
+    :   _slots{slot{value}, slot{value}, slot{value}}
+    {}
+
+    triple_buffer(const triple_buffer&) = delete;
+    triple_buffer& operator=(const triple_buffer&) = delete;
+
+    //  Producer : the slot to fill before publish()
+    T& write_buffer() noexcept
+    {
+        return _slots[_back].value;
+    }
+
+    void publish() noexcept
+    {
+        const auto previous = _middle.exchange(_back | fresh_flag, std::memory_order_acq_rel);
+        _back = previous & index_mask;
+    }
+
+    /**
+     *  Consumer : take the latest published value, if any since the
+     *  last update. A single atomic load when there is none.
+     */
+    bool update() noexcept
+    {
+        if ((_middle.load(std::memory_order_relaxed) & fresh_flag) == 0u)
+            return false;
+
+        const auto previous = _middle.exchange(_front, std::memory_order_acq_rel);
+        _front = previous & index_mask;
+        return true;
+    }
+
+    const T& read_buffer() const noexcept
+    {
+        return _slots[_front].value;
+    }
+
+private:
+    static constexpr std::uint8_t index_mask = 0x3u;
+    static constexpr std::uint8_t fresh_flag = 0x4u;
+
+    struct alignas(cache_line_size) slot
+    {
+        T value{};
+    };
+
+    std::array<slot, 3> _slots{};
+    alignas(cache_line_size) std::atomic<std::uint8_t> _middle{1u};
+    alignas(cache_line_size) std::uint8_t _back{0u};
+    alignas(cache_line_size) std::uint8_t _front{2u};
+};
+
+#endif /* TRIPLE_BUFFER_H_ */
@@ -38,6 +38,43 @@ struct type_list_append<type_list<Ts...>, T>
 
 //
 
+template <typename Tlist, typename T>
+struct type_list_push_back;
+
+template <typename Tlist, typename T>
+using type_list_push_back_t = typename type_list_push_back<Tlist, T>::type;
+
+template <typename ...Ts, typename T>
+struct type_list_push_back<type_list<Ts...>, T>
+{
+    using type = type_list<Ts..., T>;
+};
+
+//
+
+template <typename Tlist, typename T>
+struct type_list_index_of;
+
+template <typename Tlist, typename T>
+constexpr auto type_list_index_of_v = type_list_index_of<Tlist, T>::value;
+
+template <typename T>
+struct type_list_index_of<type_list<>, T>;
+
+template <typename Tfirst, typename ...Tlast, typename T>
+struct type_list_index_of<type_list<Tfirst, Tlast...>, T>
+{
+    static constexpr unsigned int value = 1u + type_list_index_of_v<type_list<Tlast...>, T>;
+};
+
+template <typename ...Tlast, typename T>
+struct type_list_index_of<type_list<T, Tlast...>, T>
+{
+    static constexpr unsigned int value = 0u;
+};
+
+//
+
 template <typename Tlist, typename T>
 struct type_list_set_insert
 {
@@ -0,0 +1,85 @@
+#ifndef VARIABLE_STORE_H_
+#define VARIABLE_STORE_H_
+
+#include <array>
+#include <cstddef>
+
+#include "../expression/expression.h"
+#include "../expression/substitute.h"
+#include "../expression/evaluate.h"
+
+/**
+ * Variable store
+ */
+template <typename Tag, typename T>
+struct variable_association {
+    T value{};
+};
+
+template <typename T, typename ...Tag>
+class variable_store : variable_association<Tag, T>...
+{
+
+public:
+    constexpr variable_store() = default;
+
+    template <typename Searchtag>
+    constexpr auto get() const
+    {
+        return variable_association<Searchtag, T>::value;
+    }
+
+    template <typename Searchtag>
+    constexpr void set(const T& val)
+    {
+        variable_association<Searchtag, T>::value = val;
+    }
+
+    //  All the values, in the order of Tag...
+    constexpr std::array<T, sizeof...(Tag)> values() const
+    {
+        return {variable_association<Tag, T>::value...};
+    }
+
+    constexpr void set_values(const std::array<T, sizeof...(Tag)>& values)
+    {
+        std::size_t index = 0u;
+        (..., (variable_association<Tag, T>::value = values[index++]));
+    }
+
+    template <typename E>
+    constexpr auto subsitute_variables(const expression<E>& e) const
+    {
+        return substitute_var_impl<E, Tag...>::subst(*this, e);
+    }
+
+    template <typename E>
+    constexpr auto eval(const expression<E>& e)
+    {
+        return evaluate(subsitute_variables(e));
+    }
+
+private:
+    
+    template <typename E, typename ...Tags>
+    struct substitute_var_impl;
+
+    template <typename E>
+    struct substitute_var_impl<E>
+    {
+        static constexpr auto subst(const variable_store&, const expression<E>& e) { return E{e}; }
+    };
+
+    template <typename E, typename FirstTag, typename ...LastTags>
+    struct substitute_var_impl<E, FirstTag, LastTags...>
+    {
+        static constexpr auto subst(const variable_store& store, const expression<E>& e)
+        {
+            const auto tmp_expr = substitute(e, variable<FirstTag>{}, store.get<FirstTag>());
+            using tmp_expr_type = std::decay_t<decltype(tmp_expr)>;
+            return substitute_var_impl<tmp_expr_type, LastTags...>::subst(store, tmp_expr);
+        }
+    };
+};
+
+#endif /* VARIABLE_STORE_H_ */